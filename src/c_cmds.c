@@ -53,6 +53,7 @@
 #include "hu_stuff.h"
 #include "i_gamepad.h"
 #include "i_system.h"
+#include "i_timer.h"
 #include "m_menu.h"
 #include "m_misc.h"
 #include "m_random.h"
@@ -192,8 +193,11 @@ extern dboolean         r_shadows;
 extern dboolean         r_shake_barrels;
 extern int              r_shake_damage;
 extern int              r_skycolor;
+extern int              r_strips;
 extern dboolean         r_textures;
 extern dboolean         r_translucency;
+extern int              r_visplanes_bytes;
+extern int              r_visplanes_total;
 extern int              s_musicvolume;
 extern dboolean         s_randommusic;
 extern dboolean         s_randompitch;
@@ -201,8 +205,11 @@ extern int              s_sfxvolume;
 extern char             *s_timiditycfgpath;
 extern char             *savegame;
 extern int              savegameselected;
+extern dboolean         savethread;
 extern char             *skilllevel;
+extern int              startuptime;
 extern int              skilllevelselected;
+extern dboolean         sleepthinkers;
 extern unsigned int     stat_barrelsexploded;
 extern unsigned int     stat_cheated;
 extern unsigned int     stat_damageinflicted;
@@ -250,6 +257,7 @@ extern char             *vid_driver;
 extern dboolean         vid_fullscreen;
 extern int              vid_motionblur;
 extern dboolean         vid_pillarboxes;
+extern dboolean         vid_presentthread;
 extern char             *vid_scaleapi;
 extern char             *vid_scalefilter;
 extern char             *vid_screenresolution;
@@ -395,6 +403,8 @@ static void pistolstart_cmd_func2(char *, char *);
 static dboolean play_cmd_func1(char *, char *);
 static void play_cmd_func2(char *, char *);
 static void playerstats_cmd_func2(char *, char *);
+static void poolstats_cmd_func2(char *, char *);
+static void profile_cmd_func2(char *, char *);
 static void quit_cmd_func2(char *, char *);
 static void regenhealth_cmd_func2(char *, char *);
 static void reset_cmd_func2(char *, char *);
@@ -410,8 +420,10 @@ static dboolean spawn_cmd_func1(char *, char *);
 static void spawn_cmd_func2(char *, char *);
 static void teleport_cmd_func2(char *, char *);
 static void thinglist_cmd_func2(char *, char *);
+static void thinkers_cmd_func2(char *, char *);
 static void unbind_cmd_func2(char *, char *);
 static void vanilla_cmd_func2(char *, char *);
+static void wadstats_cmd_func2(char *, char *);
 
 static dboolean bool_cvars_func1(char *, char *);
 static void bool_cvars_func2(char *, char *);
@@ -436,6 +448,7 @@ static void player_cvars_func2(char *, char *);
 static void playername_cvar_func2(char *, char *);
 static dboolean r_blood_cvar_func1(char *, char *);
 static void r_blood_cvar_func2(char *, char *);
+static void r_bloodsplats_max_cvar_func2(char *, char *);
 static dboolean r_detail_cvar_func1(char *, char *);
 static void r_detail_cvar_func2(char *, char *);
 static void r_dither_cvar_func2(char *, char *);
@@ -452,6 +465,7 @@ static void r_textures_cvar_func2(char *, char *);
 static void r_translucency_cvar_func2(char *, char *);
 static dboolean s_volume_cvars_func1(char *, char *);
 static void s_volume_cvars_func2(char *, char *);
+static void sleepthinkers_cvar_func2(char *, char *);
 static dboolean turbo_cvar_func1(char *, char *);
 static void turbo_cvar_func2(char *, char *);
 static dboolean units_cvar_func1(char *, char *);
@@ -460,12 +474,14 @@ static dboolean vid_capfps_cvar_func1(char *, char *);
 static void vid_capfps_cvar_func2(char *, char *);
 static void vid_display_cvar_func2(char *, char *);
 static void vid_fullscreen_cvar_func2(char *, char *);
+static void vid_presentthread_cvar_func2(char *, char *);
 static dboolean vid_scaleapi_cvar_func1(char *, char *);
 static void vid_scaleapi_cvar_func2(char *, char *);
 static dboolean vid_scalefilter_cvar_func1(char *, char *);
 static void vid_scalefilter_cvar_func2(char *, char *);
 static void vid_screenresolution_cvar_func2(char *, char *);
 static void vid_showfps_cvar_func2(char *, char *);
+static void vid_showprofile_cvar_func2(char *, char *);
 static void vid_vsync_cvar_func2(char *, char *);
 static void vid_widescreen_cvar_func2(char *, char *);
 static void vid_windowposition_cvar_func2(char *, char *);
@@ -696,6 +712,10 @@ consolecmd_t consolecmds[] =
         "The name of the player used in player messages."),
     CMD(playerstats, "", null_func1, playerstats_cmd_func2, 0, "",
         "Shows statistics about the player."),
+    CMD(poolstats, "", null_func1, poolstats_cmd_func2, 0, "",
+        "Shows statistics about the pools thinkers are\nallocated from."),
+    CMD(profile, "", null_func1, profile_cmd_func2, 1, "[<b>on</b>|<b>off</b>]",
+        "Shows how long each stage of a frame has recently\ntaken, or turns profiling on or off."),
     CMD(quit, exit, null_func1, quit_cmd_func2, 0, "",
         "Quits <i><b>"PACKAGE_NAME"</b></i>."),
     CVAR_BOOL(r_althud, "", bool_cvars_func1, bool_cvars_func2, BOOLVALUEALIAS,
@@ -704,7 +724,7 @@ consolecmd_t consolecmds[] =
         "The intensity of the red palette effect when the player\nhas the berserk power-up and their fist selected (<b>0</b>\nto <b>8</b>)."),
     CVAR_INT(r_blood, "", r_blood_cvar_func1, r_blood_cvar_func2, CF_NONE, BLOODVALUEALIAS,
         "The colors of the blood of the player and monsters (<b>all</b>,\n<b>none</b> or <b>red</b>)."),
-    CVAR_INT(r_bloodsplats_max, "", int_cvars_func1, int_cvars_func2, CF_NONE, NOVALUEALIAS,
+    CVAR_INT(r_bloodsplats_max, "", int_cvars_func1, r_bloodsplats_max_cvar_func2, CF_NONE, NOVALUEALIAS,
         "The maximum number of blood splats allowed in a map (<b>0</b>\nto <b>1,048,576</b>)."),
     CVAR_INT(r_bloodsplats_total, "", int_cvars_func1, int_cvars_func2, CF_READONLY, NOVALUEALIAS,
         "The total number of blood splats in the current map."),
@@ -770,10 +790,16 @@ consolecmd_t consolecmds[] =
         "The amount the screen shakes when the player is\nattacked."),
     CVAR_INT(r_skycolor, r_skycolour, r_skycolor_cvar_func1, r_skycolor_cvar_func2, CF_NONE, SKYVALUEALIAS,
         "The color of the sky (<b>none</b>, or <b>0</b> to <b>255</b>)."),
+    CVAR_INT(r_strips, "", int_cvars_func1, int_cvars_func2, CF_NONE, NOVALUEALIAS,
+        "The number of strips the player's view is split into,\neach rendered on its own thread (<b>1</b> to <b>16</b>)."),
     CVAR_BOOL(r_textures, "", bool_cvars_func1, r_textures_cvar_func2, BOOLVALUEALIAS,
         "Toggles displaying all textures."),
     CVAR_BOOL(r_translucency, "", bool_cvars_func1, r_translucency_cvar_func2, BOOLVALUEALIAS,
         "Toggles the translucency of sprites and textures."),
+    CVAR_INT(r_visplanes_bytes, "", int_cvars_func1, int_cvars_func2, CF_READONLY, NOVALUEALIAS,
+        "The number of bytes allocated for visplanes and\nopenings."),
+    CVAR_INT(r_visplanes_total, "", int_cvars_func1, int_cvars_func2, CF_READONLY, NOVALUEALIAS,
+        "The number of visplanes in the last frame rendered."),
     CMD(regenhealth, "", null_func1, regenhealth_cmd_func2, 1, "[<b>on</b>|<b>off</b>]",
         "Toggles regenerating health."),
     CMD(reset, "", null_func1, reset_cmd_func2, 1, RESETCMDFORMAT,
@@ -800,8 +826,12 @@ consolecmd_t consolecmds[] =
         "Saves the game to a file."),
     CVAR_STR(savegame, "", null_func1, str_cvars_func2, CF_READONLY,
         "The name of the current savegame."),
+    CVAR_BOOL(savethread, "", bool_cvars_func1, bool_cvars_func2, BOOLVALUEALIAS,
+        "Toggles writing savegames on their own thread."),
     CVAR_STR(skilllevel, "", null_func1, str_cvars_func2, CF_READONLY,
         "The current skill level."),
+    CVAR_BOOL(sleepthinkers, "", bool_cvars_func1, sleepthinkers_cvar_func2, BOOLVALUEALIAS,
+        "Toggles putting things that can't do anything to\nsleep until something happens to them."),
     CMD(spawn, summon, spawn_cmd_func1, spawn_cmd_func2, 1, SPAWNCMDFORMAT,
         "Spawns a <i>monster</i> or <i>item</i>."),
     CVAR_INT(stillbob, "", int_cvars_func1, int_cvars_func2, CF_PERCENT, NOVALUEALIAS,
@@ -810,6 +840,8 @@ consolecmd_t consolecmds[] =
         "Teleports the player to (<i>x</i>,<i>y</i>) in the current map."),
     CMD(thinglist, "", game_func1, thinglist_cmd_func2, 0, "",
         "Shows a list of things in the current map."),
+    CMD(thinkers, "", game_func1, thinkers_cmd_func2, 0, "",
+        "Shows how many thinkers in the current map are active\nand how many are sleeping."),
     CVAR_INT(turbo, "", turbo_cvar_func1, turbo_cvar_func2, CF_PERCENT, NOVALUEALIAS,
         "The speed of the player (<b>10%</b> to <b>400%</b>)."),
     CMD(unbind, "", null_func1, unbind_cmd_func2, 1, UNBINDCMDFORMAT,
@@ -834,6 +866,8 @@ consolecmd_t consolecmds[] =
         "The amount of motion blur when the player turns quickly."),
     CVAR_BOOL(vid_pillarboxes, "", bool_cvars_func1, vid_fullscreen_cvar_func2, BOOLVALUEALIAS,
         "Toggles using the pillarboxes either side of the screen\nfor palette effects."),
+    CVAR_BOOL(vid_presentthread, "", bool_cvars_func1, vid_presentthread_cvar_func2, BOOLVALUEALIAS,
+        "Toggles presenting the screen on its own thread."),
     CVAR_STR(vid_scaleapi, "", vid_scaleapi_cvar_func1, vid_scaleapi_cvar_func2, CF_NONE,
         "The API used to scale the display (<b>\"direct3d\"</b>, <b>\"opengl\"</b>\nor <b>\"software\"</b>)."),
     CVAR_STR(vid_scalefilter, "", vid_scalefilter_cvar_func1, vid_scalefilter_cvar_func2, CF_NONE,
@@ -842,6 +876,8 @@ consolecmd_t consolecmds[] =
         "The screen's resolution when fullscreen (<b>desktop</b> or\n<i>width</i><b>\xD7</b><i>height</i>)."),
     CVAR_BOOL(vid_showfps, "", bool_cvars_func1, vid_showfps_cvar_func2, BOOLVALUEALIAS,
         "Toggles showing the average number of frames per\nsecond."),
+    CVAR_BOOL(vid_showprofile, "", bool_cvars_func1, vid_showprofile_cvar_func2, BOOLVALUEALIAS,
+        "Toggles showing how long each stage of a frame has\nrecently taken."),
     CVAR_BOOL(vid_vsync, "", bool_cvars_func1, vid_vsync_cvar_func2, BOOLVALUEALIAS,
         "Toggles vertical sync with the display's refresh rate."),
     CVAR_BOOL(vid_widescreen, "", bool_cvars_func1, vid_widescreen_cvar_func2, BOOLVALUEALIAS,
@@ -854,6 +890,8 @@ consolecmd_t consolecmds[] =
     CVAR_STR(wad, "", null_func1, str_cvars_func2, CF_READONLY,
         "The last WAD to be opened using the WAD launcher."),
 #endif
+    CMD(wadstats, "", null_func1, wadstats_cmd_func2, 0, "",
+        "Shows how each WAD is being read, how long startup\ntook, and how much memory is in use."),
     CVAR_INT(weaponbob, "", int_cvars_func1, int_cvars_func2, CF_PERCENT, NOVALUEALIAS,
         "The amount the player's weapon bobs up and down when\nthey move."),
 
@@ -1659,6 +1697,9 @@ static void fastmonsters_cmd_func2(char *cmd, char *parms)
     else
         fastparm = !fastparm;
 
+    // [BH] the states of monsters that are sleeping may have changed
+    P_WakeMobjs();
+
     if (fastparm)
     {
         G_SetFastMonsters(true);
@@ -1688,6 +1729,8 @@ static void freeze_cmd_func2(char *cmd, char *parms)
     else
         freeze = !freeze;
 
+    P_WakeMobjs();
+
     if (freeze)
     {
         HU_PlayerMessage(s_STSTR_FON, false);
@@ -3378,6 +3421,70 @@ static void playerstats_cmd_func2(char *cmd, char *parms)
         C_PlayerStats_NoGame();
 }
 
+//
+// poolstats CCMD
+//
+static void poolstats_cmd_func2(char *cmd, char *parms)
+{
+    int         tabs[8] = { 120, 190, 260, 330, 0, 0, 0, 0 };
+    zpool_t     *pool;
+
+    C_TabbedOutput(tabs, POOLSTATSTITLE);
+
+    for (pool = zpools; pool; pool = pool->next)
+        C_TabbedOutput(tabs, "%s\t<b>%s</b>\t<b>%s</b>\t<b>%s</b>\t<b>%s</b>", pool->name,
+            commify(pool->live), commify(pool->peak), commify(pool->pooled), commify(pool->numslabs));
+}
+
+//
+// profile CCMD
+//
+static dboolean profilecmd;
+
+static void profile_cmd_func2(char *cmd, char *parms)
+{
+    if (*parms)
+    {
+        int     value = C_LookupValueFromAlias(parms, BOOLVALUEALIAS);
+
+        if (value == 0)
+            profilecmd = false;
+        else if (value == 1)
+        {
+            if (!profiling)
+                I_ResetProfile();
+
+            profilecmd = true;
+        }
+
+        profiling = (profilecmd || vid_showprofile);
+        C_Output("Profiling is %s.", (profiling ? "on" : "off"));
+    }
+    else if (!profiling)
+        C_Output("Profiling is off. Enter <b>profile on</b> to turn it on.");
+    else
+    {
+        int     tabs[8] = { 80, 160, 240, 0, 0, 0, 0, 0 };
+        int     i;
+        float   min, avg, p99;
+
+        C_TabbedOutput(tabs, PROFILETITLE);
+
+        for (i = 0; i < NUMPROFILESTAGES; i++)
+            if (I_GetProfileStats(i, &min, &avg, &p99))
+                C_TabbedOutput(tabs, "%s\t<b>%.2fms</b>\t<b>%.2fms</b>\t<b>%.2fms</b>",
+                    profilestagenames[i], min, avg, p99);
+
+        if (I_GetProfileStats(ps_interval, &min, &avg, &p99))
+            C_Output("Frames are presented every <b>%.2fms</b> on average, with a jitter of <b>%.2fms</b>.",
+                avg, I_GetProfileDeviation(ps_interval));
+
+        if (sightcachehits + sightcachemisses)
+            C_Output("<b>%s</b> of the <b>%s</b> sight checks made in this map were found in the "
+                "sight cache.", commify(sightcachehits), commify(sightcachehits + sightcachemisses));
+    }
+}
+
 //
 // quit CCMD
 //
@@ -3566,6 +3673,8 @@ static void respawnmonsters_cmd_func2(char *cmd, char *parms)
     else
         respawnmonsters = !respawnmonsters;
 
+    P_WakeMobjs();
+
     HU_PlayerMessage((respawnmonsters ? s_STSTR_RMON : s_STSTR_RMOFF), false);
 }
 
@@ -3821,6 +3930,24 @@ static void thinglist_cmd_func2(char *cmd, char *parms)
     }
 }
 
+//
+// thinkers CCMD
+//
+static void thinkers_cmd_func2(char *cmd, char *parms)
+{
+    thinker_t   *th;
+    int         count = 0;
+
+    for (th = thinkercap.next; th != &thinkercap; th = th->next)
+        count++;
+
+    C_Output("There are <b>%s</b> thinkers in this map. <b>%s</b> are active and <b>%s</b> are "
+        "sleeping.", commify(count), commify(count - sleepingthinkers), commify(sleepingthinkers));
+
+    if (!sleepthinkers)
+        C_Output("Enter <b>sleepthinkers on</b> to put things that can't do anything to sleep.");
+}
+
 //
 // vanilla CCMD
 //
@@ -3877,6 +4004,41 @@ static void unbind_cmd_func2(char *cmd, char *parms)
     bind_cmd_func2(cmd, M_StringJoin(parms, " none", NULL));
 }
 
+//
+// wadstats CCMD
+//
+static void wadstats_cmd_func2(char *cmd, char *parms)
+{
+    wad_file_t  *wad_file = NULL;
+    uint64_t    rss = I_GetResidentSetSize();
+    int         i;
+
+    for (i = 0; i < numlumps; i++)
+        if (lumpinfo[i]->wad_file != wad_file)
+        {
+            wad_file = lumpinfo[i]->wad_file;
+            C_Output("<b>%s</b> is %s.", wad_file->path,
+                (wad_file->mapped ? "mapped into memory" : "read from when lumps are needed"));
+        }
+
+    C_Output("<b>%s</b> lump%s (<b>%sKB</b>) %s used where they are in mapped WADs.",
+        commify(mappedlumps), (mappedlumps == 1 ? "" : "s"), commify(mappedlumpsize / 1024),
+        (mappedlumps == 1 ? "is" : "are"));
+    C_Output("<b>%s</b> lump%s (<b>%sKB</b>) %s been read into memory.",
+        commify(readlumps), (readlumps == 1 ? "" : "s"), commify(readlumpsize / 1024),
+        (readlumps == 1 ? "has" : "have"));
+    C_Output("Startup took <b>%s</b> seconds%s.", striptrailingzero(startuptime / 1000.0f, 2),
+        (nocache ? " without the startup cache" : ""));
+
+    if (!nocache)
+        C_Output("<b>%s</b> WAD%s hashed again for the startup cache, taking <b>%s</b> seconds.",
+            commify(hashedwads), (hashedwads == 1 ? " was" : "s were"),
+            striptrailingzero(hashedwadstime / 1000.0f, 2));
+
+    if (rss)
+        C_Output("<b>%sMB</b> of memory is currently in use.", commify(rss / (1024 * 1024)));
+}
+
 //
 // boolean CVARs
 //
@@ -4469,6 +4631,18 @@ static void r_blood_cvar_func2(char *cmd, char *parms)
     }
 }
 
+//
+// r_bloodsplats_max CVAR
+//
+static void r_bloodsplats_max_cvar_func2(char *cmd, char *parms)
+{
+    int_cvars_func2(cmd, parms);
+
+    // [BH] remove the oldest splats now if there are too many, even if there are to be none
+    if (*parms)
+        P_ResizeBloodSplatRing();
+}
+
 //
 // r_detail CVAR
 //
@@ -4730,7 +4904,7 @@ static void r_textures_cvar_func2(char *cmd, char *parms)
             for (i = 0; i < numsectors; i++)
             {
                 mobj_t          *mo = sectors[i].thinglist;
-                bloodsplat_t    *splat = sectors[i].splatlist;
+                int             j;
 
                 while (mo)
                 {
@@ -4743,10 +4917,12 @@ static void r_textures_cvar_func2(char *cmd, char *parms)
                     mo = mo->snext;
                 }
 
-                while (splat)
+                for (j = 0; j < sectors[i].numsplats; j++)
                 {
+                    bloodsplat_t    *splat = &sectors[i].splats[(sectors[i].firstsplat + j)
+                                        % sectors[i].maxsplats];
+
                     splat->colfunc = (splat->blood == FUZZYBLOOD ? fuzzcolfunc : bloodsplatcolfunc);
-                    splat = splat->snext;
                 }
             }
         }
@@ -4785,7 +4961,7 @@ static void r_translucency_cvar_func2(char *cmd, char *parms)
             for (i = 0; i < numsectors; i++)
             {
                 mobj_t          *mo = sectors[i].thinglist;
-                bloodsplat_t    *splat = sectors[i].splatlist;
+                int             j;
 
                 while (mo)
                 {
@@ -4798,10 +4974,12 @@ static void r_translucency_cvar_func2(char *cmd, char *parms)
                     mo = mo->snext;
                 }
 
-                while (splat)
+                for (j = 0; j < sectors[i].numsplats; j++)
                 {
+                    bloodsplat_t    *splat = &sectors[i].splats[(sectors[i].firstsplat + j)
+                                        % sectors[i].maxsplats];
+
                     splat->colfunc = (splat->blood == FUZZYBLOOD ? fuzzcolfunc : bloodsplatcolfunc);
-                    splat = splat->snext;
                 }
             }
         }
@@ -4887,6 +5065,16 @@ static void s_volume_cvars_func2(char *cmd, char *parms)
     }
 }
 
+//
+// sleepthinkers CVAR
+//
+static void sleepthinkers_cvar_func2(char *cmd, char *parms)
+{
+    bool_cvars_func2(cmd, parms);
+    if (!sleepthinkers && sleepingthinkers)
+        P_WakeMobjs();
+}
+
 //
 // turbo CVAR
 //
@@ -5026,6 +5214,23 @@ static void vid_fullscreen_cvar_func2(char *cmd, char *parms)
         I_ToggleFullscreen();
 }
 
+//
+// vid_presentthread CVAR
+//
+static void vid_presentthread_cvar_func2(char *cmd, char *parms)
+{
+    dboolean    vid_presentthread_old = vid_presentthread;
+
+    bool_cvars_func2(cmd, parms);
+    if (vid_presentthread != vid_presentthread_old)
+    {
+        if (vid_presentthread)
+            I_StartPresenter();
+        else
+            I_StopPresenter();
+    }
+}
+
 //
 // vid_scaleapi CVAR
 //
@@ -5153,6 +5358,23 @@ static void vid_showfps_cvar_func2(char *cmd, char *parms)
     }
 }
 
+//
+// vid_showprofile CVAR
+//
+static void vid_showprofile_cvar_func2(char *cmd, char *parms)
+{
+    dboolean    vid_showprofile_old = vid_showprofile;
+
+    bool_cvars_func2(cmd, parms);
+    if (vid_showprofile != vid_showprofile_old)
+    {
+        if (!profiling)
+            I_ResetProfile();
+
+        profiling = (profilecmd || vid_showprofile);
+    }
+}
+
 //
 // vid_vsync CVAR
 //
@@ -5246,7 +5468,11 @@ static void vid_windowsize_cvar_func2(char *cmd, char *parms)
             M_SaveCVARs();
 
             if (!vid_fullscreen)
+            {
+                I_LockRenderer();
                 SDL_SetWindowSize(window, windowwidth, windowheight);
+                I_UnlockRenderer();
+            }
         }
     }
     else
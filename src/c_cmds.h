@@ -48,6 +48,8 @@
 #define CVARLISTTITLE           "CVAR\tDEFAULT\tDESCRIPTION"
 #define MAPLISTTITLE            "MAP\tNAME\tWAD"
 #define PLAYERSTATSTITLE        "STAT\tCURRENT MAP\tTOTAL"
+#define POOLSTATSTITLE          "POOL\tLIVE\tPEAK\tPOOLED\tSLABS"
+#define PROFILETITLE            "STAGE\tMIN\tAVERAGE\t99TH PERCENTILE"
 
 typedef enum
 {
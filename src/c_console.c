@@ -914,6 +914,44 @@ void C_UpdateFPS(void)
     }
 }
 
+void C_UpdateProfile(void)
+{
+    if (!wipe && !menuactive)
+    {
+        static char     buffer[NUMPROFILESTAGES + 1][64];
+        static int      updatetime = -1000;
+        int             now = I_GetTimeMS();
+        int             y = CONSOLETEXTY + (vid_showfps ? CONSOLELINEHEIGHT : 0);
+        int             i;
+
+        // only work out the stats once a second
+        if (now - updatetime >= 1000)
+        {
+            updatetime = now;
+            M_StringCopy(buffer[0], "min avg p99 ms", sizeof(buffer[0]));
+
+            for (i = 0; i < NUMPROFILESTAGES; i++)
+            {
+                float   min, avg, p99;
+
+                if (I_GetProfileStats(i, &min, &avg, &p99))
+                    M_snprintf(buffer[i + 1], sizeof(buffer[i + 1]), "%s %.2f %.2f %.2f",
+                        profilestagenames[i], min, avg, p99);
+                else
+                    *buffer[i + 1] = '\0';
+            }
+        }
+
+        for (i = 0; i <= NUMPROFILESTAGES; i++)
+            if (*buffer[i])
+            {
+                C_DrawOverlayText(CONSOLEWIDTH - C_TextWidth(buffer[i], false) - CONSOLETEXTX + 1, y,
+                    buffer[i], consolehighfpscolor);
+                y += CONSOLELINEHEIGHT;
+            }
+    }
+}
+
 void C_Drawer(void)
 {
     if (consoleheight)
@@ -125,5 +125,6 @@ void C_PrintCompileDate(void);
 void C_PrintSDLVersions(void);
 void C_StripQuotes(char *string);
 void C_UpdateFPS(void);
+void C_UpdateProfile(void);
 
 #endif
@@ -1926,12 +1926,12 @@ dboolean CheckPackageWADVersion(void)
 
                 if (M_StringCompare(inbuffer, PACKAGE_NAMEANDVERSIONSTRING))
                 {
-                    Z_ChangeTag(infile.lump, PU_CACHE);
+                    W_ReleaseLumpNum(i);
                     return true;
                 }
             }
 
-            Z_ChangeTag(infile.lump, PU_CACHE);
+            W_ReleaseLumpNum(i);
         }
     return false;
 }
@@ -2072,7 +2072,7 @@ void ProcessDehFile(char *filename, int lumpnum)
     }
 
     if (infile.lump)
-        Z_ChangeTag(infile.lump, PU_CACHE);     // Mark purgeable
+        W_ReleaseLumpNum(lumpnum);              // Mark purgeable
     else
         fclose(infile.f);                       // Close real file
 
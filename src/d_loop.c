@@ -172,10 +172,15 @@ void TryRunTics(void)
     // run the count tics
     while (counts--)
     {
+        uint64_t    time = (profiling ? I_GetProfileTime() : 0);
+
         if (advancetitle)
             D_DoAdvanceTitle();
 
         G_Ticker();
+
+        if (profiling && time)
+            I_AddProfileSample(ps_tics, I_GetProfileTime() - time);
         gametic++;
         gametime++;
 
@@ -69,6 +69,7 @@
 #include "p_local.h"
 #include "p_saveg.h"
 #include "p_setup.h"
+#include "p_tick.h"
 #include "s_sound.h"
 #include "st_stuff.h"
 #include "v_video.h"
@@ -138,9 +139,26 @@ dboolean                forcewipe;
 dboolean                splashscreen;
 
 int                     startuptimer;
+int                     startuptime;
 
 dboolean                realframe;
 
+// [BH] -benchmark
+static int              benchmarkframes;
+static char             *benchmarkpath;
+
+// [BH] -simulate
+static int              simulatetics;
+static unsigned int     simulateseed = 1;
+
+extern fixed_t          angleturn[3];
+extern fixed_t          forwardmove[2];
+extern char             mapnum[6];
+extern dboolean         nomusic;
+extern dboolean         nosfx;
+extern int              r_strips;
+extern fixed_t          sidemove[2];
+
 extern dboolean         alwaysrun;
 extern unsigned int     stat_cheated;
 
@@ -215,6 +233,9 @@ void D_Display(void)
     int                 tics;
     int                 wipestart;
     dboolean            done;
+    dboolean            profile = profiling;
+    uint64_t            starttime = (profile ? I_GetProfileTime() : 0);
+    uint64_t            rendertime = 0;
 
     if ((realframe = (vid_capfps == TICRATE || gametic > saved_gametic)))
         saved_gametic = gametic;
@@ -268,7 +289,20 @@ void D_Display(void)
         ST_Drawer((viewheight == SCREENHEIGHT), true);
 
         // draw the view directly
-        R_RenderPlayerView(&players[0]);
+        if (profile)
+        {
+            uint64_t    phasetime[NUMRENDERPHASES];
+            uint64_t    time = I_GetProfileTime();
+
+            memcpy(phasetime, renderphasetime, sizeof(phasetime));
+            R_RenderPlayerView(&players[0]);
+            rendertime = I_GetProfileTime() - time;
+            I_AddProfileSample(ps_bsp, renderphasetime[rp_bsp] - phasetime[rp_bsp]);
+            I_AddProfileSample(ps_planes, renderphasetime[rp_planes] - phasetime[rp_planes]);
+            I_AddProfileSample(ps_masked, renderphasetime[rp_masked] - phasetime[rp_masked]);
+        }
+        else
+            R_RenderPlayerView(&players[0]);
 
         if (am_path && !(players[0].cheats & CF_NOCLIP) && !freeze)
             AM_addToPath();
@@ -343,10 +377,33 @@ void D_Display(void)
         if (drawdisk)
             HU_DrawDisk();
 
-        // normal update
-        blitfunc();             // blit buffer
+        if (profile)
+        {
+            uint64_t    time;
+            uint64_t    endtime;
+
+            if (vid_showprofile)
+                C_UpdateProfile();
 
-        mapblitfunc();
+            time = I_GetProfileTime();
+            I_AddProfileSample(ps_hud, time - starttime - rendertime);
+
+            // normal update
+            blitfunc();         // blit buffer
+
+            mapblitfunc();
+
+            endtime = I_GetProfileTime();
+            I_AddProfileSample(ps_blit, endtime - time);
+            I_AddProfileSample(ps_frame, endtime - starttime);
+        }
+        else
+        {
+            // normal update
+            blitfunc();         // blit buffer
+
+            mapblitfunc();
+        }
 
         return;
     }
@@ -394,6 +451,7 @@ void D_DoomLoop(void)
 
     while (1)
     {
+        G_UpdateSaveGame();
         TryRunTics(); // will run at least one tic
 
         if (players[0].mo)
@@ -1648,6 +1706,14 @@ static void D_DoomMainSetup(void)
 
     C_PrintSDLVersions();
 
+    if ((nommap = M_CheckParm("-nommap")))
+        C_Output("A <b>-nommap</b> parameter was found on the command-line. Lumps will be read "
+            "from each WAD when they are needed.");
+
+    if ((nocache = M_CheckParm("-nocache")))
+        C_Output("A <b>-nocache</b> parameter was found on the command-line. Tables that are "
+            "kept in the startup cache will be generated again.");
+
     iwadfile = D_FindIWAD();
 
     modifiedgame = false;
@@ -1794,6 +1860,9 @@ static void D_DoomMainSetup(void)
     if (!CheckPackageWADVersion())
         I_Error("%s is the wrong version.\nPlease reinstall "PACKAGE_NAME".", packagewad);
 
+    // Generate the WAD hash table. Speed things up a bit.
+    W_GenerateHashTable();
+
     FREEDOOM = (W_CheckNumForName("FREEDOOM") >= 0);
     FREEDM = (W_CheckNumForName("FREEDM") >= 0);
 
@@ -1827,12 +1896,37 @@ static void D_DoomMainSetup(void)
 
     bfgedition = (DMENUPIC && W_CheckNumForName("M_ACPT") >= 0);
 
-    // Generate the WAD hash table. Speed things up a bit.
-    W_GenerateHashTable();
+    p = M_CheckParmWithArgs("-benchmark", 1, 1);
+    if (p)
+    {
+        benchmarkframes = MAX(1, atoi(myargv[p + 1]));
+        if (p + 2 < myargc && *myargv[p + 2] != '-')
+            benchmarkpath = myargv[p + 2];
+
+        C_Output("A <b>-benchmark</b> parameter was found on the command-line. %s frames will "
+            "be rendered without a window.", commify(benchmarkframes));
+        nomusic = true;
+        nosfx = true;
+    }
+    else if ((p = M_CheckParmWithArgs("-simulate", 1, 1)))
+    {
+        simulatetics = MAX(1, atoi(myargv[p + 1]));
+
+        if ((p = M_CheckParmWithArgs("-seed", 1, 1)))
+            simulateseed = (unsigned int)strtoul(myargv[p + 1], NULL, 10);
+
+        C_Output("A <b>-simulate</b> parameter was found on the command-line. %s tics will be run "
+            "without a window.", commify(simulatetics));
+        nomusic = true;
+        nosfx = true;
+    }
 
     I_InitGamepad();
 
-    I_InitGraphics();
+    if (benchmarkframes || simulatetics)
+        I_InitHeadlessGraphics();
+    else
+        I_InitGraphics();
 
     D_IdentifyVersion();
     InitGameVersion();
@@ -2028,7 +2122,7 @@ static void D_DoomMainSetup(void)
     creditlump = W_CacheLumpName("CREDIT", PU_CACHE);
     playpal = W_CacheLumpName("PLAYPAL", PU_CACHE);
 
-    if (gameaction != ga_loadgame)
+    if (gameaction != ga_loadgame && !benchmarkframes && !simulatetics)
     {
         if (autostart)
         {
@@ -2043,8 +2137,9 @@ static void D_DoomMainSetup(void)
             D_StartTitle(!!M_CheckParm("-nosplash"));    // start up intro loop
     }
 
-    C_Output("Startup took %s seconds to complete.",
-        striptrailingzero((I_GetTimeMS() - startuptimer) / 1000.0f, 2));
+    startuptime = I_GetTimeMS() - startuptimer;
+    C_Output("Startup took %s seconds to complete%s.", striptrailingzero(startuptime / 1000.0f, 2),
+        (nocache ? " without the startup cache" : ""));
 
     // Ty 04/08/98 - Add 5 lines of misc. data, only if non-blank
     // The expectation is that these will be set in a .bex file
@@ -2066,6 +2161,307 @@ static void D_DoomMainSetup(void)
     C_AddConsoleDivider();
 }
 
+//
+// D_Benchmark
+// [BH] Render frames of a map from a number of viewpoints without a window,
+//  and print how long each phase took as JSON. The viewpoints are either read
+//  from a file, with a line for each of the form "x y angle", in which case the
+//  view moves smoothly between them, or the player start and every thing in the
+//  map, in which case the view turns on the spot at each of them in turn.
+//
+typedef struct
+{
+    fixed_t     x;
+    fixed_t     y;
+    angle_t     angle;
+} benchpoint_t;
+
+static benchpoint_t *D_LoadBenchmarkPath(int *numpoints)
+{
+    benchpoint_t    *points = NULL;
+    int             maxpoints = 0;
+    FILE            *file = fopen(benchmarkpath, "rt");
+    char            line[256];
+
+    *numpoints = 0;
+
+    if (!file)
+        I_Error("%s couldn't be opened.", benchmarkpath);
+
+    while (fgets(line, sizeof(line), file))
+    {
+        double  x, y, angle;
+
+        if (sscanf(line, "%10lf %10lf %10lf", &x, &y, &angle) != 3)
+            continue;
+
+        if (*numpoints == maxpoints)
+            points = Z_Realloc(points, (maxpoints = (maxpoints ? maxpoints * 2 : 64)) * sizeof(*points));
+
+        points[*numpoints].x = (fixed_t)(x * FRACUNIT);
+        points[*numpoints].y = (fixed_t)(y * FRACUNIT);
+        points[(*numpoints)++].angle = (angle_t)(int64_t)(angle * ANG45 / 45);
+    }
+
+    fclose(file);
+
+    if (!*numpoints)
+        I_Error("No viewpoints were found in %s.", benchmarkpath);
+
+    return points;
+}
+
+static benchpoint_t *D_GetBenchmarkPath(int *numpoints)
+{
+    benchpoint_t    *points;
+    thinker_t       *th;
+    int             i = 1;
+
+    *numpoints = 1;
+
+    for (th = thinkerclasscap[th_mobj].cnext; th != &thinkerclasscap[th_mobj]; th = th->cnext)
+        if (!((mobj_t *)th)->player)
+            (*numpoints)++;
+
+    points = Z_Malloc(*numpoints * sizeof(*points), PU_STATIC, NULL);
+    points[0].x = players[0].mo->x;
+    points[0].y = players[0].mo->y;
+    points[0].angle = players[0].mo->angle;
+
+    for (th = thinkerclasscap[th_mobj].cnext; th != &thinkerclasscap[th_mobj]; th = th->cnext)
+    {
+        mobj_t  *mo = (mobj_t *)th;
+
+        if (!mo->player)
+        {
+            points[i].x = mo->x;
+            points[i].y = mo->y;
+            points[i++].angle = mo->angle;
+        }
+    }
+
+    return points;
+}
+
+static void D_Benchmark(void)
+{
+    player_t        *player = &players[0];
+    mobj_t          *mo;
+    benchpoint_t    *points;
+    int             numpoints;
+    int             i;
+    int             y;
+    uint64_t        rendertime = 0;
+    uint64_t        hudtime = 0;
+    uint64_t        checksum = 0;
+    uint64_t        start;
+    double          seconds;
+
+    G_InitNew(startskill, startepisode, startmap);
+
+    if (setsizeneeded)
+        R_ExecuteSetViewSize();
+
+    mo = player->mo;
+    points = (benchmarkpath ? D_LoadBenchmarkPath(&numpoints) : D_GetBenchmarkPath(&numpoints));
+    memset(renderphasetime, 0, sizeof(renderphasetime));
+
+    for (i = 0; i < benchmarkframes; i++)
+    {
+        uint64_t    time;
+
+        P_UnsetThingPosition(mo);
+
+        if (benchmarkpath)
+        {
+            // move smoothly from one viewpoint to the next
+            double          t = (benchmarkframes > 1 ? (double)i * (numpoints - 1) / (benchmarkframes - 1) : 0.0);
+            int             j = MIN((int)t, numpoints - 1);
+            benchpoint_t    *p1 = &points[j];
+            benchpoint_t    *p2 = &points[MIN(j + 1, numpoints - 1)];
+            fixed_t         frac = (fixed_t)((t - j) * FRACUNIT);
+
+            mo->x = p1->x + FixedMul(p2->x - p1->x, frac);
+            mo->y = p1->y + FixedMul(p2->y - p1->y, frac);
+            mo->angle = p1->angle + (angle_t)FixedMul((int)(p2->angle - p1->angle), frac);
+        }
+        else
+        {
+            // turn on the spot at each viewpoint
+            int             j = (int)((int64_t)i * numpoints / benchmarkframes);
+            int             first = (int)(((int64_t)j * benchmarkframes + numpoints - 1) / numpoints);
+            int             last = (int)(((int64_t)(j + 1) * benchmarkframes + numpoints - 1) / numpoints);
+
+            mo->x = points[j].x;
+            mo->y = points[j].y;
+            mo->angle = points[j].angle + (angle_t)((uint64_t)(i - first) * 0x100000000ull
+                / MAX(1, last - first));
+        }
+
+        P_SetThingPosition(mo);
+        mo->z = mo->floorz = mo->subsector->sector->floorheight;
+        mo->ceilingz = mo->subsector->sector->ceilingheight;
+        player->viewz = MIN(mo->z + VIEWHEIGHT, mo->ceilingz - 4 * FRACUNIT);
+
+        start = I_GetTimeUS();
+        R_RenderPlayerView(player);
+        time = I_GetTimeUS();
+        rendertime += time - start;
+
+        // [BH] hash the player's view, so the frames rendered with any number of
+        //  render strips can be checked to be exactly the same
+        for (y = 0; y < viewheight; y++)
+            checksum = W_HashData(checksum, &screens[0][(viewwindowy + y) * SCREENWIDTH + viewwindowx],
+                viewwidth);
+
+        time = I_GetTimeUS();
+        HU_Erase();
+        ST_Drawer((viewheight == SCREENHEIGHT), true);
+        HU_Drawer();
+        hudtime += I_GetTimeUS() - time;
+    }
+
+    seconds = (rendertime + hudtime) / 1000000.0;
+
+    printf("{\"map\": \"%s\", \"frames\": %i, \"viewpoints\": %i, \"width\": %i, \"height\": %i, "
+        "\"strips\": %i, \"seconds\": %.6f, \"fps\": %.2f, \"ms\": {\"bsp\": %.4f, "
+        "\"planes\": %.4f, \"masked\": %.4f, \"render\": %.4f, \"hud\": %.4f}, "
+        "\"checksum\": \"%016llx\"}\n",
+        mapnum, benchmarkframes, numpoints, viewwidth, viewheight, r_strips, seconds,
+        benchmarkframes / seconds,
+        renderphasetime[rp_bsp] / 1000.0 / benchmarkframes,
+        renderphasetime[rp_planes] / 1000.0 / benchmarkframes,
+        renderphasetime[rp_masked] / 1000.0 / benchmarkframes,
+        rendertime / 1000.0 / benchmarkframes,
+        hudtime / 1000.0 / benchmarkframes, (unsigned long long)checksum);
+    fflush(stdout);
+
+    I_Quit(false);
+}
+
+//
+// D_Simulate
+// [BH] Run tics of a map without a window or rendering anything, and print how long they
+//  took, how long was spent in each type of thinker, and how many times some of the more
+//  expensive functions in the playsim were called, as JSON. The player is given the same
+//  ticcmds every run, and can't die, so every run of a map does the same amount of work.
+//
+typedef struct
+{
+    think_t     function;
+    char        *name;
+} thinkername_t;
+
+static thinkername_t thinkernames[] =
+{
+    { P_MobjThinker,          "things"        },
+    { T_MoveCeiling,          "ceilings"      },
+    { T_VerticalDoor,         "doors"         },
+    { T_MoveElevator,         "elevators"     },
+    { T_FireFlicker,          "fire flickers" },
+    { T_MoveFloor,            "floors"        },
+    { T_Glow,                 "glows"         },
+    { T_LightFlash,           "light flashes" },
+    { T_PlatRaise,            "platforms"     },
+    { T_Pusher,               "pushers"       },
+    { T_Scroll,               "scrollers"     },
+    { T_StrobeFlash,          "strobes"       },
+    { P_RemoveThinkerDelayed, "removals"      }
+};
+
+static char *D_GetThinkerName(think_t function)
+{
+    int i;
+
+    for (i = 0; i < arrlen(thinkernames); i++)
+        if (thinkernames[i].function == function)
+            return thinkernames[i].name;
+
+    return "other";
+}
+
+// [BH] The player's ticcmd only depends on the tic, so is the same every run.
+static void D_GetSimulatedTiccmd(ticcmd_t *cmd, int tic)
+{
+    memset(cmd, 0, sizeof(*cmd));
+
+    // run forward for 3 seconds, then back for 1
+    cmd->forwardmove = (signed char)(tic % (4 * TICRATE) < 3 * TICRATE ? forwardmove[1] : -forwardmove[1]);
+
+    // strafe one way then the other every 2 seconds
+    cmd->sidemove = (signed char)((tic / (2 * TICRATE)) & 1 ? sidemove[1] : -sidemove[1]);
+
+    // turn one way then the other every 5 seconds
+    cmd->angleturn = (short)((tic / (5 * TICRATE)) & 1 ? angleturn[0] : -angleturn[0]);
+
+    // fire for the first half of every second
+    if (tic % TICRATE < TICRATE / 2)
+        cmd->buttons = BT_ATTACK;
+}
+
+static void D_Simulate(void)
+{
+    thinker_t   *th;
+    int         things = 0;
+    int         thinkers = 0;
+    int         tics = 0;
+    int         i;
+    uint64_t    start;
+    double      seconds;
+
+    G_InitNew(startskill, startepisode, startmap);
+
+    // P_SetupLevel() seeds rand() from the time, so every run would play differently
+    srand(simulateseed);
+
+    players[0].cheats |= CF_GODMODE;
+
+    for (th = thinkercap.next; th != &thinkercap; th = th->next)
+    {
+        thinkers++;
+
+        if (th->function == P_MobjThinker)
+            things++;
+    }
+
+    timethinkers = true;
+    numthinkertimes = 0;
+    memset(thinkertimes, 0, sizeof(thinkertimes));
+    checksightcalls = 0;
+    trymovecalls = 0;
+    pathtraversecalls = 0;
+
+    start = I_GetTimeUS();
+
+    // stop early if the player exits the map
+    while (tics < simulatetics && gamestate == GS_LEVEL)
+    {
+        D_GetSimulatedTiccmd(&netcmds[gametic % BACKUPTICS], tics++);
+        G_Ticker();
+        gametic++;
+        gametime++;
+    }
+
+    start = I_GetTimeUS() - start;
+    seconds = (start ? start : 1) / 1000000.0;
+    timethinkers = false;
+
+    printf("{\"map\": \"%s\", \"tics\": %i, \"seed\": %u, \"things\": %i, \"thinkers\": %i, "
+        "\"sleepthinkers\": %s, \"seconds\": %.6f, \"ticspersecond\": %.2f, \"ms\": {\"tic\": %.4f",
+        mapnum, tics, simulateseed, things, thinkers, (sleepthinkers ? "true" : "false"), seconds,
+        tics / seconds, seconds * 1000.0 / MAX(1, tics));
+
+    for (i = 0; i < numthinkertimes; i++)
+        printf(", \"%s\": %.4f", D_GetThinkerName(thinkertimes[i].function),
+            thinkertimes[i].time / 1000.0 / MAX(1, tics));
+
+    printf("}, \"calls\": {\"P_CheckSight\": %i, \"P_TryMove\": %i, \"P_PathTraverse\": %i}}\n",
+        checksightcalls, trymovecalls, pathtraversecalls);
+    fflush(stdout);
+
+    I_Quit(false);
+}
+
 //
 // D_DoomMain
 //
@@ -2073,5 +2469,11 @@ void D_DoomMain(void)
 {
     D_DoomMainSetup();          // CPhipps - setup out of main execution stack
 
+    if (benchmarkframes)
+        D_Benchmark();          // never returns
+
+    if (simulatetics)
+        D_Simulate();           // never returns
+
     D_DoomLoop();               // never returns
 }
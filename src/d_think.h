@@ -71,6 +71,10 @@ typedef struct thinker_s
     // killough 11/98: count of how many other objects reference
     // this one using pointers. Used for garbage collection.
     unsigned int        references;
+
+    // [BH] order thinker was added in, and whether it is skipped by P_RunThinkers()
+    unsigned int        order;
+    dboolean            sleeping;
 } thinker_t;
 
 #endif
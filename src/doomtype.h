@@ -60,6 +60,12 @@ typedef uint8_t byte;
 #define PATH_SEPARATOR  ':'
 #endif
 
+#if defined(_MSC_VER)
+#define THREADLOCAL     __declspec(thread)
+#else
+#define THREADLOCAL     __thread
+#endif
+
 #define arrlen(array) (sizeof(array) / sizeof(*array))
 
 #endif
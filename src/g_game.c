@@ -40,6 +40,8 @@
 #include <Windows.h>
 #endif
 
+#include "SDL.h"
+
 #include "am_map.h"
 #include "c_console.h"
 #include "d_deh.h"
@@ -1481,28 +1483,34 @@ void G_LoadGame(char *name)
 
 void G_DoLoadGame(void)
 {
-    int savedleveltime;
+    int         savedleveltime;
+    uint64_t    loadtime;
 
     I_SetPalette(W_CacheLumpName("PLAYPAL", PU_CACHE));
 
+    // [BH] the savegame might still be being written
+    G_WaitForSaveGame();
+
     loadaction = gameaction;
     gameaction = ga_nothing;
 
-    if (!(save_stream = fopen(savename, "rb")))
+    // [BH] the time taken to load the base level isn't counted
+    loadtime = I_GetTimeUS();
+
+    if (!P_OpenSaveGame(savename))
         return;
 
     if (!P_ReadSaveGameHeader(savedescription))
-    {
-        fclose(save_stream);
         return;
-    }
 
     savedleveltime = leveltime;
+    loadtime = I_GetTimeUS() - loadtime;
 
     // load a base level
     G_InitNew(gameskill, gameepisode, gamemap);
 
     leveltime = savedleveltime;
+    loadtime = I_GetTimeUS() - loadtime;
 
     // unarchive all the modifications
     P_UnArchivePlayers();
@@ -1521,7 +1529,7 @@ void G_DoLoadGame(void)
     if (!P_ReadSaveGameEOF())
         I_Error("Bad savegame");
 
-    fclose(save_stream);
+    loadtime = I_GetTimeUS() - loadtime;
 
     if (setsizeneeded)
         R_ExecuteSetViewSize();
@@ -1539,6 +1547,8 @@ void G_DoLoadGame(void)
         C_Output("<b>%s</b> loaded.", savename);
         C_HideConsoleFast();
     }
+
+    C_Output("The savegame took %s milliseconds to load.", striptrailingzero(loadtime / 1000.0f, 2));
 }
 
 void G_LoadedGameMessage(void)
@@ -1570,62 +1580,168 @@ void G_SaveGame(int slot, char *description, char *name)
     drawdisk = true;
 }
 
-void G_DoSaveGame(void)
+//
+// SAVE THREAD
+// [BH] When savethread is on, the game is written into memory between tics, which is
+//  quick, and then written to disk on a thread of its own while the game carries on.
+//  The result is reported by the main thread once the savegame thread has finished.
+// Savegames are only made on the main thread, so saver and savejob are only touched by
+//  the main thread while the savegame thread isn't running.
+//
+dboolean                savethread = savethread_default;
+
+static SDL_Thread       *saver;
+static SDL_atomic_t     saverfinished;
+
+static struct
+{
+    byte        *buffer;
+    size_t      length;
+    size_t      written;
+    char        *file;
+    char        name[256];
+    char        description[SAVESTRINGSIZE];
+    dboolean    console;
+    uint64_t    snapshottime;
+    uint64_t    writetime;
+} savejob;
+
+static void G_WriteSaveGame(void)
 {
     char        *temp_savegame_file = P_TempSaveGameFile();
-    char        *savegame_file = (consoleactive ? savename : P_SaveGameFile(savegameslot));
+    uint64_t    writetime = I_GetTimeUS();
+
+    // We write to a temporary file and then rename it at the end if it was
+    // successfully written. This prevents an existing savegame from being
+    // overwritten by a corrupted one, or if a savegame buffer overrun occurs.
+    if ((savejob.written = P_WriteSaveGame(temp_savegame_file, savejob.buffer, savejob.length)))
+    {
+        // Now rename the temporary savegame file to the actual savegame
+        // file, overwriting the old savegame if there was one there.
+        remove(savejob.file);
 
-    // Open the savegame file for writing. We write to a temporary file
-    // and then rename it at the end if it was successfully written.
-    // This prevents an existing savegame from being overwritten by
-    // a corrupted one, or if a savegame buffer overrun occurs.
-    save_stream = fopen(temp_savegame_file, "wb");
+        if (rename(temp_savegame_file, savejob.file))
+            savejob.written = 0;
+    }
+    else
+        remove(temp_savegame_file);
+
+    P_FreeSaveGame(savejob.buffer);
+    savejob.buffer = NULL;
+    savejob.writetime = I_GetTimeUS() - writetime;
+}
 
-    if (!save_stream)
+static int SDLCALL G_SaveGameThread(void *data)
+{
+    G_WriteSaveGame();
+    SDL_AtomicSet(&saverfinished, 1);
+    return 0;
+}
+
+static void G_SaveGameFinished(void)
+{
+    if (!savejob.written)
     {
         menuactive = false;
         C_ShowConsole();
-        C_Warning("%s couldn't be saved.", savename);
+        C_Warning("%s couldn't be saved.", savejob.file);
     }
     else
     {
-        P_WriteSaveGameHeader(savedescription);
-
-        P_ArchivePlayers();
-        P_ArchiveWorld();
-        P_ArchiveThinkers();
-        P_ArchiveSpecials();
-        P_ArchiveMap();
-
-        P_WriteSaveGameEOF();
-
-        // Finish up, close the savegame file.
-        fclose(save_stream);
-
-        // Now rename the temporary savegame file to the actual savegame
-        // file, overwriting the old savegame if there was one there.
-        remove(savegame_file);
-        rename(temp_savegame_file, savegame_file);
-
-        if (consoleactive)
-            C_Output("<b>%s</b> saved.", savename);
+        if (savejob.console)
+            C_Output("<b>%s</b> saved.", savejob.name);
         else
         {
             static char     buffer[1024];
 
-            M_snprintf(buffer, sizeof(buffer), s_GGSAVED, titlecase(savedescription));
+            M_snprintf(buffer, sizeof(buffer), s_GGSAVED, titlecase(savejob.description));
             HU_PlayerMessage(buffer, false);
             message_dontfuckwithme = true;
             S_StartSound(NULL, sfx_swtchx);
         }
 
-        // draw the pattern into the back screen
-        R_FillBackScreen();
+        C_Output("The savegame took %s milliseconds to save and %s milliseconds to write, and is "
+            "%s bytes.", striptrailingzero(savejob.snapshottime / 1000.0f, 2),
+            striptrailingzero(savejob.writetime / 1000.0f, 2), commify(savejob.written));
+    }
+
+    free(savejob.file);
+    savejob.file = NULL;
+}
+
+//
+// G_UpdateSaveGame
+// Reports the result of a savegame once the savegame thread has finished writing it.
+//  Called from the game loop on the main thread.
+//
+void G_UpdateSaveGame(void)
+{
+    if (saver && SDL_AtomicGet(&saverfinished))
+    {
+        SDL_WaitThread(saver, NULL);
+        saver = NULL;
+        G_SaveGameFinished();
+    }
+}
+
+//
+// G_WaitForSaveGame
+// Waits for the savegame thread to finish writing a savegame, if it's writing one.
+//
+void G_WaitForSaveGame(void)
+{
+    if (saver)
+    {
+        SDL_WaitThread(saver, NULL);
+        saver = NULL;
+        G_SaveGameFinished();
     }
+}
+
+void G_DoSaveGame(void)
+{
+    uint64_t    snapshottime;
+
+    // [BH] only one savegame is written at a time
+    G_WaitForSaveGame();
+
+    // [BH] Write the savegame into memory first, and then to disk in one go.
+    snapshottime = I_GetTimeUS();
+    P_CreateSaveGame();
+    P_WriteSaveGameHeader(savedescription);
+
+    P_ArchivePlayers();
+    P_ArchiveWorld();
+    P_ArchiveThinkers();
+    P_ArchiveSpecials();
+    P_ArchiveMap();
+
+    P_WriteSaveGameEOF();
+
+    savejob.buffer = P_TakeSaveGame(&savejob.length);
+    savejob.file = M_StringJoin((consoleactive ? savename : P_SaveGameFile(savegameslot)), NULL);
+    M_StringCopy(savejob.name, savename, sizeof(savejob.name));
+    M_StringCopy(savejob.description, savedescription, sizeof(savejob.description));
+    savejob.console = consoleactive;
+    savejob.snapshottime = I_GetTimeUS() - snapshottime;
+
+    // draw the pattern into the back screen
+    R_FillBackScreen();
 
     gameaction = ga_nothing;
 
     drawdisk = false;
+
+    if (savethread)
+    {
+        SDL_AtomicSet(&saverfinished, 0);
+
+        if ((saver = SDL_CreateThread(G_SaveGameThread, "G_SaveGameThread", NULL)))
+            return;
+    }
+
+    G_WriteSaveGame();
+    G_SaveGameFinished();
 }
 
 skill_t d_skill;
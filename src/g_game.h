@@ -64,6 +64,9 @@ void G_DoLoadGame(void);
 // Called by M_Responder.
 void G_SaveGame(int slot, char *description, char *name);
 
+void G_UpdateSaveGame(void);
+void G_WaitForSaveGame(void);
+
 void G_ExitLevel(void);
 void G_SecretExitLevel(void);
 
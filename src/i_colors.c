@@ -222,10 +222,10 @@ void FindNearestColors(byte *palette)
             nearestcolors[i] = i;
 }
 
-static byte *GenerateTintTable(byte *palette, int percent, byte filter[PALETTESIZE], int colors)
+static void GenerateTintTable(byte *result, byte *palette, int percent, byte filter[PALETTESIZE],
+    int colors)
 {
-    byte        *result = Z_Malloc(PALETTESIZE * PALETTESIZE, PU_STATIC, NULL);
-    int         foreground, background;
+    int foreground, background;
 
     for (foreground = 0; foreground < PALETTESIZE; foreground++)
     {
@@ -265,39 +265,67 @@ static byte *GenerateTintTable(byte *palette, int percent, byte filter[PALETTESI
             for (background = 0; background < PALETTESIZE; background++)
                 *(result + (background << 8) + foreground) = foreground;
     }
-
-    return result;
 }
 
 extern dboolean r_dither;
 
+// [BH] The tint tables, in the order they're kept in the startup cache
+static struct
+{
+    byte        **table;
+    int         percent;
+    int         colors;
+} tinttabs[] =
+{
+    { &tinttab,           ADDITIVE, ALL                      },
+    { &tinttab20,         20,       ALL                      },
+    { &tinttab25,         25,       ALL                      },
+    { &tinttab33,         33,       ALL                      },
+    { &tinttab40,         40,       ALL                      },
+    { &tinttab50,         50,       ALL                      },
+    { &tinttab60,         60,       ALL                      },
+    { &tinttab66,         66,       ALL                      },
+    { &tinttab75,         75,       ALL                      },
+    { &tinttab80,         80,       ALL                      },
+    { &tinttabred,        ADDITIVE, REDS                     },
+    { &tinttabredwhite1,  ADDITIVE, (REDS | WHITES)          },
+    { &tinttabredwhite2,  ADDITIVE, (REDS | WHITES | EXTRAS) },
+    { &tinttabgreen,      ADDITIVE, GREENS                   },
+    { &tinttabblue,       ADDITIVE, BLUES                    },
+    { &tinttabred33,      33,       REDS                     },
+    { &tinttabredwhite50, 50,       (REDS | WHITES)          },
+    { &tinttabgreen33,    33,       GREENS                   },
+    { &tinttabblue25,     25,       BLUES                    }
+};
+
 void I_InitTintTables(byte *palette)
 {
     lumpindex_t lump;
+    size_t      size = arrlen(tinttabs) * PALETTESIZE * PALETTESIZE;
+    uint64_t    key = W_HashData(W_HashData(0, palette, PALETTESIZE * 3), general, sizeof(general));
+    size_t      cachesize;
+    byte        *tables = W_LoadCache("tinttabs", key, &cachesize);
+    int         i;
 
-    tinttab = GenerateTintTable(palette, ADDITIVE, general, ALL);
+    // [BH] Finding the nearest colors for every table takes a while, so they're only
+    //  generated when the palette changes, and are loaded from the startup cache otherwise.
+    if (!tables || cachesize != size)
+    {
+        if (tables)
+            Z_Free(tables);
 
-    tinttab20 = GenerateTintTable(palette, 20, general, ALL);
-    tinttab25 = GenerateTintTable(palette, 25, general, ALL);
-    tinttab33 = GenerateTintTable(palette, 33, general, ALL);
-    tinttab40 = GenerateTintTable(palette, 40, general, ALL);
-    tinttab50 = GenerateTintTable(palette, 50, general, ALL);
-    tinttab60 = GenerateTintTable(palette, 60, general, ALL);
-    tinttab66 = GenerateTintTable(palette, 66, general, ALL);
-    tinttab75 = GenerateTintTable(palette, 75, general, ALL);
-    tinttab80 = GenerateTintTable(palette, 80, general, ALL);
+        tables = Z_Malloc(size, PU_STATIC, NULL);
 
-    tranmap = ((lump = W_CheckNumForName("TRANMAP")) != -1 ? W_CacheLumpNum(lump, PU_STATIC) :
-        (r_dither ? tinttab25 : tinttab50));
+        for (i = 0; i < arrlen(tinttabs); i++)
+            GenerateTintTable(tables + i * PALETTESIZE * PALETTESIZE, palette, tinttabs[i].percent,
+                general, tinttabs[i].colors);
 
-    tinttabred = GenerateTintTable(palette, ADDITIVE, general, REDS);
-    tinttabredwhite1 = GenerateTintTable(palette, ADDITIVE, general, (REDS | WHITES));
-    tinttabredwhite2 = GenerateTintTable(palette, ADDITIVE, general, (REDS | WHITES | EXTRAS));
-    tinttabgreen = GenerateTintTable(palette, ADDITIVE, general, GREENS);
-    tinttabblue = GenerateTintTable(palette, ADDITIVE, general, BLUES);
+        W_SaveCache("tinttabs", key, tables, size);
+    }
 
-    tinttabred33 = GenerateTintTable(palette, 33, general, REDS);
-    tinttabredwhite50 = GenerateTintTable(palette, 50, general, (REDS | WHITES));
-    tinttabgreen33 = GenerateTintTable(palette, 33, general, GREENS);
-    tinttabblue25 = GenerateTintTable(palette, 25, general, BLUES);
+    for (i = 0; i < arrlen(tinttabs); i++)
+        *tinttabs[i].table = tables + i * PALETTESIZE * PALETTESIZE;
+
+    tranmap = ((lump = W_CheckNumForName("TRANMAP")) != -1 ? W_CacheLumpNum(lump, PU_STATIC) :
+        (r_dither ? tinttab25 : tinttab50));
 }
@@ -38,14 +38,20 @@
 
 #if defined(_WIN32)
 #include <Windows.h>
+#include <Psapi.h>
 
 void I_ShutdownWindows32(void);
 #else
+#if defined(__APPLE__)
+#include <mach/mach.h>
+#endif
+
 #include <unistd.h>
 #endif
 
 #include "c_console.h"
 #include "doomstat.h"
+#include "g_game.h"
 #include "i_gamepad.h"
 #include "i_timer.h"
 #include "m_config.h"
@@ -204,6 +210,49 @@ void I_PrintSystemInfo(void)
         cores, (cores > 1 ? "s" : ""), commify(SDL_GetSystemRAM()));
 }
 
+//
+// I_GetResidentSetSize
+// [BH] Returns how much of the process is in physical memory, in bytes, or 0 if that
+//  can't be found.
+//
+#if defined(_WIN32)
+typedef BOOL(WINAPI *PGETPROCESSMEMORYINFO)(HANDLE, PPROCESS_MEMORY_COUNTERS, DWORD);
+#endif
+
+uint64_t I_GetResidentSetSize(void)
+{
+#if defined(_WIN32)
+    PGETPROCESSMEMORYINFO       pGetProcessMemoryInfo = (PGETPROCESSMEMORYINFO)GetProcAddress(
+                                    GetModuleHandle("kernel32.dll"), "K32GetProcessMemoryInfo");
+    PROCESS_MEMORY_COUNTERS     counters;
+
+    if (pGetProcessMemoryInfo && pGetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return counters.WorkingSetSize;
+#elif defined(__APPLE__)
+    mach_task_basic_info_data_t info;
+    mach_msg_type_number_t      count = MACH_TASK_BASIC_INFO_COUNT;
+
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t)&info, &count) == KERN_SUCCESS)
+        return info.resident_size;
+#else
+    FILE                        *file = fopen("/proc/self/statm", "r");
+
+    if (file)
+    {
+        unsigned long   size;
+        unsigned long   resident;
+        int             result = fscanf(file, "%10lu %10lu", &size, &resident);
+
+        fclose(file);
+
+        if (result == 2)
+            return (uint64_t)resident * sysconf(_SC_PAGESIZE);
+    }
+#endif
+
+    return 0;
+}
+
 //
 // I_Quit
 //
@@ -211,6 +260,9 @@ void I_Quit(dboolean shutdown)
 {
     if (shutdown)
     {
+        // [BH] don't quit before a savegame has been written
+        G_WaitForSaveGame();
+
         S_Shutdown();
 
         if (returntowidescreen)
@@ -57,4 +57,6 @@ void I_Error(char *error, ...);
 void I_PrintWindowsVersion(void);
 void I_PrintSystemInfo(void);
 
+uint64_t I_GetResidentSetSize(void);
+
 #endif
@@ -36,16 +36,52 @@
 ========================================================================
 */
 
+#include <math.h>
+#include <string.h>
+
+#if !defined(_WIN32)
+#include <errno.h>
+#include <time.h>
+#endif
+
 #include "doomdef.h"
+#include "i_timer.h"
+#include "m_fixed.h"
 #include "SDL.h"
 
+// [BH] I_GetTime(), I_GetTimeMS() and I_GetTimeUS() are all read from SDL's
+//  performance counter, counted from the first time any of them is called, so
+//  they can never drift apart
+static uint64_t basecounter;
+static uint64_t counterfrequency;
+
+//
+// I_GetTimeUS
+// [BH] Same as I_GetTimeMS, but returns time in microseconds
+//
+uint64_t I_GetTimeUS(void)
+{
+    uint64_t    counter;
+
+    if (!counterfrequency)
+    {
+        counterfrequency = SDL_GetPerformanceFrequency();
+        basecounter = SDL_GetPerformanceCounter();
+    }
+
+    counter = SDL_GetPerformanceCounter() - basecounter;
+
+    return (counter / counterfrequency * 1000000
+        + counter % counterfrequency * 1000000 / counterfrequency);
+}
+
 //
 // I_GetTime
 // returns time in 1/35th second tics
 //
 int I_GetTime(void)
 {
-    return SDL_GetTicks() * TICRATE / 1000;
+    return (int)(I_GetTimeUS() * TICRATE / 1000000);
 }
 
 //
@@ -53,7 +89,33 @@ int I_GetTime(void)
 //
 int I_GetTimeMS(void)
 {
-    return SDL_GetTicks();
+    return (int)(I_GetTimeUS() / 1000);
+}
+
+//
+// I_SleepUntilUS
+// [BH] Sleep until I_GetTimeUS() reaches time, or as close to it as the OS allows.
+//  The sleep is relative, so it's measured against the same clock as everything else.
+//
+void I_SleepUntilUS(uint64_t time)
+{
+    uint64_t        now = I_GetTimeUS();
+
+    if (time <= now)
+        return;
+
+#if defined(_WIN32)
+    SDL_Delay((Uint32)((time - now) / 1000));
+#else
+    {
+        struct timespec ts;
+
+        ts.tv_sec = (time - now) / 1000000;
+        ts.tv_nsec = (time - now) % 1000000 * 1000;
+
+        while (nanosleep(&ts, &ts) == -1 && errno == EINTR);
+    }
+#endif
 }
 
 //
@@ -68,4 +130,106 @@ void I_InitTimer(void)
 {
     // initialize timer
     SDL_InitSubSystem(SDL_INIT_TIMER);
+
+    // [BH] start counting I_GetTimeUS() if it hasn't already
+    I_GetTimeUS();
+}
+
+//
+// [BH] Profiler
+// The last PROFILESAMPLES times of each stage are kept in milliseconds, and
+//  nothing is recorded unless profiling is true.
+//
+#define PROFILESAMPLES  512
+
+typedef struct
+{
+    float       samples[PROFILESAMPLES];
+    int         numsamples;
+    int         next;
+} profile_t;
+
+dboolean        profiling;
+
+char            *profilestagenames[NUMPROFILESTAGES] =
+{
+    "tics", "bsp", "planes", "masked", "hud", "blit", "frame", "interval"
+};
+
+static profile_t    profile[NUMPROFILESTAGES];
+
+uint64_t I_GetProfileTime(void)
+{
+    return I_GetTimeUS();
+}
+
+void I_AddProfileSample(profilestage_t stage, uint64_t time)
+{
+    profile_t   *p = &profile[stage];
+
+    p->samples[p->next] = time / 1000.0f;
+    p->next = (p->next + 1) % PROFILESAMPLES;
+    p->numsamples = MIN(p->numsamples + 1, PROFILESAMPLES);
+}
+
+static int cmpfloats(const void *a, const void *b)
+{
+    float   x = *(const float *)a;
+    float   y = *(const float *)b;
+
+    return ((x > y) - (x < y));
+}
+
+dboolean I_GetProfileStats(profilestage_t stage, float *min, float *avg, float *p99)
+{
+    profile_t   *p = &profile[stage];
+    float       sorted[PROFILESAMPLES];
+    float       total = 0.0f;
+    int         i;
+
+    if (!p->numsamples)
+        return false;
+
+    memcpy(sorted, p->samples, p->numsamples * sizeof(*sorted));
+    qsort(sorted, p->numsamples, sizeof(*sorted), cmpfloats);
+
+    for (i = 0; i < p->numsamples; i++)
+        total += sorted[i];
+
+    *min = sorted[0];
+    *avg = total / p->numsamples;
+    *p99 = sorted[MIN(p->numsamples * 99 / 100, p->numsamples - 1)];
+    return true;
+}
+
+//
+// I_GetProfileDeviation
+// [BH] The standard deviation of a stage's times, which for ps_interval is how
+//  unevenly frames are being presented.
+//
+float I_GetProfileDeviation(profilestage_t stage)
+{
+    profile_t   *p = &profile[stage];
+    float       total = 0.0f;
+    float       variance = 0.0f;
+    float       avg;
+    int         i;
+
+    if (!p->numsamples)
+        return 0.0f;
+
+    for (i = 0; i < p->numsamples; i++)
+        total += p->samples[i];
+
+    avg = total / p->numsamples;
+
+    for (i = 0; i < p->numsamples; i++)
+        variance += (p->samples[i] - avg) * (p->samples[i] - avg);
+
+    return sqrtf(variance / p->numsamples);
+}
+
+void I_ResetProfile(void)
+{
+    memset(profile, 0, sizeof(profile));
 }
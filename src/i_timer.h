@@ -39,6 +39,8 @@
 #if !defined(__I_TIMER_H__)
 #define __I_TIMER_H__
 
+#include "doomtype.h"
+
 // Called by D_DoomLoop,
 // returns current time in tics.
 int I_GetTime(void);
@@ -46,10 +48,37 @@ int I_GetTime(void);
 // returns current time in ms
 int I_GetTimeMS(void);
 
+// [BH] returns current time in us
+uint64_t I_GetTimeUS(void);
+void I_SleepUntilUS(uint64_t time);
+
 // Pause for a specified number of ms
 void I_Sleep(int ms);
 
 // Initialize timer
 void I_InitTimer(void);
 
+// [BH] Stages of a frame timed by the profiler
+typedef enum
+{
+    ps_tics,
+    ps_bsp,
+    ps_planes,
+    ps_masked,
+    ps_hud,
+    ps_blit,
+    ps_frame,
+    ps_interval,
+    NUMPROFILESTAGES
+} profilestage_t;
+
+extern dboolean         profiling;
+extern char             *profilestagenames[NUMPROFILESTAGES];
+
+uint64_t I_GetProfileTime(void);
+void I_AddProfileSample(profilestage_t stage, uint64_t time);
+dboolean I_GetProfileStats(profilestage_t stage, float *min, float *avg, float *p99);
+float I_GetProfileDeviation(profilestage_t stage);
+void I_ResetProfile(void);
+
 #endif
@@ -53,6 +53,7 @@
 #include "i_colors.h"
 #include "i_gamepad.h"
 #include "i_system.h"
+#include "i_timer.h"
 #include "m_config.h"
 #include "m_menu.h"
 #include "m_misc.h"
@@ -63,6 +64,18 @@
 #include "w_wad.h"
 #include "z_zone.h"
 
+#if defined(__i386__) || defined(__x86_64__) || defined(_M_IX86) || defined(_M_X64)
+#define SIMDBLIT
+
+#include <immintrin.h>
+
+#if defined(__GNUC__)
+#define TARGET(isa)     __attribute__((target(isa)))
+#else
+#define TARGET(isa)
+#endif
+#endif
+
 #define MAXDISPLAYS             8
 
 #define MAXUPSCALEWIDTH         (1600 / ORIGINALWIDTH)
@@ -86,10 +99,12 @@ char                    *vid_driver = vid_driver_default;
 dboolean                vid_fullscreen = vid_fullscreen_default;
 int                     vid_motionblur = vid_motionblur_default;
 dboolean                vid_pillarboxes = vid_pillarboxes_default;
+dboolean                vid_presentthread = vid_presentthread_default;
 char                    *vid_scaleapi = vid_scaleapi_default;
 char                    *vid_scalefilter = vid_scalefilter_default;
 char                    *vid_screenresolution = vid_screenresolution_default;
 dboolean                vid_showfps;
+dboolean                vid_showprofile;
 dboolean                vid_vsync = vid_vsync_default;
 dboolean                vid_widescreen = vid_widescreen_default;
 char                    *vid_windowposition = vid_windowposition_default;
@@ -106,7 +121,9 @@ static SDL_Surface      *surface;
 static SDL_Surface      *buffer;
 static SDL_Palette      *palette;
 static SDL_Color        colors[256];
+static Uint32           pallut[256];
 static byte             *playpal;
+static dboolean         motionblur;
 
 byte                    *mapscreen;
 SDL_Window              *mapwindow;
@@ -192,8 +209,13 @@ int                     refreshrate;
 #if defined(_WIN32)
 static UINT             CapFPSTimer;
 static HANDLE           CapFPSEvent;
+#else
+static uint64_t         capfpsperiod;
+static uint64_t         capfpsnext;
 #endif
 
+static uint64_t         lastpacedframe;
+
 // Mouse acceleration
 //
 // This emulates some of the behavior of DOS mouse drivers by increasing
@@ -360,11 +382,57 @@ void I_CapFPS(int fps)
             }
         }
     }
+#else
+    capfpsperiod = (!fps || fps == TICRATE ? 0 : 1000000 / fps);
+    capfpsnext = 0;
+#endif
+}
+
+#if !defined(_WIN32)
+// [BH] sleep until this long before each frame is due, and then spin for the rest
+#define CAPFPSSPIN      1000
+#endif
+
+//
+// I_PaceFrame
+// [BH] Wait until the next frame is due before it is presented, if the framerate is
+//  capped. Outside of Windows, most of the wait is slept away using I_SleepUntilUS(),
+//  and the rest spent spinning so frames are presented as evenly as possible.
+//
+static void I_PaceFrame(void)
+{
+    uint64_t    time;
+
+#if defined(_WIN32)
+    if (CapFPSEvent)
+        WaitForSingleObject(CapFPSEvent, 1000);
+#else
+    if (capfpsperiod)
+    {
+        uint64_t    now = I_GetTimeUS();
+
+        if (capfpsnext > now + CAPFPSSPIN)
+            I_SleepUntilUS(capfpsnext - CAPFPSSPIN);
+
+        while ((now = I_GetTimeUS()) < capfpsnext);
+
+        // [BH] don't try to catch up if more than a frame behind
+        capfpsnext = (now - capfpsnext > capfpsperiod ? now : capfpsnext) + capfpsperiod;
+    }
 #endif
+
+    time = I_GetProfileTime();
+
+    if (profiling && lastpacedframe)
+        I_AddProfileSample(ps_interval, time - lastpacedframe);
+
+    lastpacedframe = time;
 }
 
 static void FreeSurfaces(void)
 {
+    I_StopPresenter();
+
     SDL_FreePalette(palette);
     SDL_FreeSurface(surface);
     SDL_FreeSurface(buffer);
@@ -422,6 +490,15 @@ static int AccelerateMouse(int value)
         return value;
 }
 
+// [BH] Events that resize the window also update the renderer, so the presenter thread
+//  mustn't be using it at the same time
+static void I_PumpEvents(void)
+{
+    I_LockRenderer();
+    SDL_PumpEvents();
+    I_UnlockRenderer();
+}
+
 // Warp the mouse back to the middle of the screen
 static void CenterMouse(void)
 {
@@ -429,7 +506,7 @@ static void CenterMouse(void)
     SDL_WarpMouseInWindow(window, displaycenterx, displaycentery);
 
     // Clear any relative movement caused by warping
-    SDL_PumpEvents();
+    I_PumpEvents();
     SDL_GetRelativeMouseState(NULL, NULL);
 }
 
@@ -447,7 +524,9 @@ static void I_GetEvent(void)
     static dboolean     enterdown;
 #endif
 
-    while (SDL_PollEvent(Event))
+    I_PumpEvents();
+
+    while (SDL_PeepEvents(Event, 1, SDL_GETEVENT, SDL_FIRSTEVENT, SDL_LASTEVENT) > 0)
     {
         switch (Event->type)
         {
@@ -724,7 +803,7 @@ static void UpdateGrab(void)
 
         SDL_WarpMouseInWindow(window, windowwidth - 10 * windowwidth / SCREENWIDTH,
             windowheight - 16);
-        SDL_PumpEvents();
+        I_PumpEvents();
         SDL_GetRelativeMouseState(NULL, NULL);
     }
 
@@ -767,19 +846,86 @@ static void CalculateFPS(void)
     C_UpdateFPS();
 }
 
+//
+// I_ExpandRow
+// [BH] Expand a row of palette indices into ARGB8888 using a 256-entry lookup table
+//
+static void I_ExpandRow(const byte *src, Uint32 *dest, int width, const Uint32 *lut)
+{
+    while (width >= 4)
+    {
+        dest[0] = lut[src[0]];
+        dest[1] = lut[src[1]];
+        dest[2] = lut[src[2]];
+        dest[3] = lut[src[3]];
+        src += 4;
+        dest += 4;
+        width -= 4;
+    }
+
+    while (width--)
+        *dest++ = lut[*src++];
+}
+
+#if defined(SIMDBLIT)
+TARGET("avx2") static void I_ExpandRowAVX2(const byte *src, Uint32 *dest, int width, const Uint32 *lut)
+{
+    while (width >= 8)
+    {
+        __m256i indices = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)src));
+
+        _mm256_storeu_si256((__m256i *)dest, _mm256_i32gather_epi32((const int *)lut, indices, 4));
+        src += 8;
+        dest += 8;
+        width -= 8;
+    }
+
+    I_ExpandRow(src, dest, width, lut);
+}
+#endif
+
+static void (*expandrowfunc)(const byte *, Uint32 *, int, const Uint32 *) = I_ExpandRow;
+
+//
+// I_ExpandScreen
+// [BH] Lock the streaming texture and expand a screen straight into it, rather than
+//  blitting it to a 32-bit surface and then copying that to the texture.
+//
+static dboolean I_ExpandScreen(const byte *src, const Uint32 *lut, SDL_Rect *rect)
+{
+    void    *pixels;
+    int     pitch;
+    int     y;
+
+    if (SDL_LockTexture(texture, rect, &pixels, &pitch) < 0)
+        return false;
+
+    for (y = 0; y < rect->h; y++)
+        expandrowfunc(src + y * SCREENWIDTH, (Uint32 *)((byte *)pixels + y * pitch), rect->w, lut);
+
+    SDL_UnlockTexture(texture);
+    return true;
+}
+
+static void I_UpdateTexture(void)
+{
+    // [BH] motion blur blends each frame over the last one, so still needs SDL's blitter
+    if (motionblur || !I_ExpandScreen(surface->pixels, pallut, &src_rect))
+    {
+        SDL_LowerBlit(surface, &src_rect, buffer, &src_rect);
+        SDL_UpdateTexture(texture, &src_rect, buffer->pixels, SCREENWIDTH * 4);
+    }
+}
+
 static void I_Blit(void)
 {
     UpdateGrab();
 
-    SDL_LowerBlit(surface, &src_rect, buffer, &src_rect);
-    SDL_UpdateTexture(texture, &src_rect, buffer->pixels, SCREENWIDTH * 4);
+    I_UpdateTexture();
     SDL_RenderClear(renderer);
     SDL_RenderCopy(renderer, texture, &src_rect, NULL);
 
-#if defined(_WIN32)
-    if (CapFPSEvent)
-        WaitForSingleObject(CapFPSEvent, 1000);
-#endif
+    I_PaceFrame();
 
     SDL_RenderPresent(renderer);
 }
@@ -788,18 +934,14 @@ static void I_Blit_NearestLinear(void)
 {
     UpdateGrab();
 
-    SDL_LowerBlit(surface, &src_rect, buffer, &src_rect);
-    SDL_UpdateTexture(texture, &src_rect, buffer->pixels, SCREENWIDTH * 4);
+    I_UpdateTexture();
     SDL_RenderClear(renderer);
     SDL_SetRenderTarget(renderer, texture_upscaled);
     SDL_RenderCopy(renderer, texture, &src_rect, NULL);
     SDL_SetRenderTarget(renderer, NULL);
     SDL_RenderCopy(renderer, texture_upscaled, NULL, NULL);
 
-#if defined(_WIN32)
-    if (CapFPSEvent)
-        WaitForSingleObject(CapFPSEvent, 1000);
-#endif
+    I_PaceFrame();
 
     SDL_RenderPresent(renderer);
 }
@@ -810,15 +952,11 @@ static void I_Blit_ShowFPS(void)
 
     CalculateFPS();
 
-    SDL_LowerBlit(surface, &src_rect, buffer, &src_rect);
-    SDL_UpdateTexture(texture, &src_rect, buffer->pixels, SCREENWIDTH * 4);
+    I_UpdateTexture();
     SDL_RenderClear(renderer);
     SDL_RenderCopy(renderer, texture, &src_rect, NULL);
 
-#if defined(_WIN32)
-    if (CapFPSEvent)
-        WaitForSingleObject(CapFPSEvent, 1000);
-#endif
+    I_PaceFrame();
 
     SDL_RenderPresent(renderer);
 }
@@ -829,18 +967,14 @@ static void I_Blit_NearestLinear_ShowFPS(void)
 
     CalculateFPS();
 
-    SDL_LowerBlit(surface, &src_rect, buffer, &src_rect);
-    SDL_UpdateTexture(texture, &src_rect, buffer->pixels, SCREENWIDTH * 4);
+    I_UpdateTexture();
     SDL_RenderClear(renderer);
     SDL_SetRenderTarget(renderer, texture_upscaled);
     SDL_RenderCopy(renderer, texture, &src_rect, NULL);
     SDL_SetRenderTarget(renderer, NULL);
     SDL_RenderCopy(renderer, texture_upscaled, NULL, NULL);
 
-#if defined(_WIN32)
-    if (CapFPSEvent)
-        WaitForSingleObject(CapFPSEvent, 1000);
-#endif
+    I_PaceFrame();
 
     SDL_RenderPresent(renderer);
 }
@@ -849,16 +983,12 @@ static void I_Blit_Shake(void)
 {
     UpdateGrab();
 
-    SDL_LowerBlit(surface, &src_rect, buffer, &src_rect);
-    SDL_UpdateTexture(texture, &src_rect, buffer->pixels, SCREENWIDTH * 4);
+    I_UpdateTexture();
     SDL_RenderClear(renderer);
     SDL_RenderCopyEx(renderer, texture, &src_rect, NULL,
         M_RandomInt(-1000, 1000) / 1000.0 * r_shake_damage / 100.0, NULL, SDL_FLIP_NONE);
 
-#if defined(_WIN32)
-    if (CapFPSEvent)
-        WaitForSingleObject(CapFPSEvent, 1000);
-#endif
+    I_PaceFrame();
 
     SDL_RenderPresent(renderer);
 }
@@ -867,8 +997,7 @@ static void I_Blit_NearestLinear_Shake(void)
 {
     UpdateGrab();
 
-    SDL_LowerBlit(surface, &src_rect, buffer, &src_rect);
-    SDL_UpdateTexture(texture, &src_rect, buffer->pixels, SCREENWIDTH * 4);
+    I_UpdateTexture();
     SDL_RenderClear(renderer);
     SDL_SetRenderTarget(renderer, texture_upscaled);
     SDL_RenderCopyEx(renderer, texture, &src_rect, NULL,
@@ -876,10 +1005,7 @@ static void I_Blit_NearestLinear_Shake(void)
     SDL_SetRenderTarget(renderer, NULL);
     SDL_RenderCopy(renderer, texture_upscaled, NULL, NULL);
 
-#if defined(_WIN32)
-    if (CapFPSEvent)
-        WaitForSingleObject(CapFPSEvent, 1000);
-#endif
+    I_PaceFrame();
 
     SDL_RenderPresent(renderer);
 }
@@ -890,16 +1016,12 @@ static void I_Blit_ShowFPS_Shake(void)
 
     CalculateFPS();
 
-    SDL_LowerBlit(surface, &src_rect, buffer, &src_rect);
-    SDL_UpdateTexture(texture, &src_rect, buffer->pixels, SCREENWIDTH * 4);
+    I_UpdateTexture();
     SDL_RenderClear(renderer);
     SDL_RenderCopyEx(renderer, texture, &src_rect, NULL,
         M_RandomInt(-1000, 1000) / 1000.0 * r_shake_damage / 100.0, NULL, SDL_FLIP_NONE);
 
-#if defined(_WIN32)
-    if (CapFPSEvent)
-        WaitForSingleObject(CapFPSEvent, 1000);
-#endif
+    I_PaceFrame();
 
     SDL_RenderPresent(renderer);
 }
@@ -910,8 +1032,7 @@ static void I_Blit_NearestLinear_ShowFPS_Shake(void)
 
     CalculateFPS();
 
-    SDL_LowerBlit(surface, &src_rect, buffer, &src_rect);
-    SDL_UpdateTexture(texture, &src_rect, buffer->pixels, SCREENWIDTH * 4);
+    I_UpdateTexture();
     SDL_RenderClear(renderer);
     SDL_SetRenderTarget(renderer, texture_upscaled);
     SDL_RenderCopyEx(renderer, texture, &src_rect, NULL,
@@ -919,17 +1040,266 @@ static void I_Blit_NearestLinear_ShowFPS_Shake(void)
     SDL_SetRenderTarget(renderer, NULL);
     SDL_RenderCopy(renderer, texture_upscaled, NULL, NULL);
 
-#if defined(_WIN32)
-    if (CapFPSEvent)
-        WaitForSingleObject(CapFPSEvent, 1000);
-#endif
+    I_PaceFrame();
+
+    SDL_RenderPresent(renderer);
+}
+
+//
+// Presenter thread
+// [BH] When vid_presentthread is on, each blit just copies the screen into one of three
+//  frames and hands it to a thread that expands, upscales and presents it. The main loop
+//  can then render the next frame while this one waits for vsync. If frames are rendered
+//  faster than they can be presented, the frame waiting to be presented is replaced.
+//
+#define NUMPRESENTFRAMES    3
+
+typedef struct
+{
+    byte                *pixels;
+    Uint32              *blended;
+    dboolean            motionblur;
+    Uint32              pallut[256];
+    int                 height;
+    double              angle;
+} presentframe_t;
+
+static presentframe_t   presentframes[NUMPRESENTFRAMES];
+static SDL_Thread       *presenter;
+static SDL_mutex        *rendererlock;
+static SDL_mutex        *presentframelock;
+static SDL_sem          *presentsem;
+static int              presentready = -1;
+static int              presenting = -1;
+static dboolean         presentquit;
+static dboolean         presentopengl;
+static dboolean         blitshake;
+
+//
+// I_LockRenderer
+// [BH] Only one thread may use the renderer at a time while the presenter thread is
+//  running, and an OpenGL context must be released before another thread can use it.
+//
+void I_LockRenderer(void)
+{
+    if (rendererlock)
+        SDL_LockMutex(rendererlock);
+}
+
+void I_UnlockRenderer(void)
+{
+    if (rendererlock)
+    {
+        if (presentopengl && SDL_GL_GetCurrentContext())
+            SDL_GL_MakeCurrent(window, NULL);
+
+        SDL_UnlockMutex(rendererlock);
+    }
+}
+
+static void I_PresentFrame(presentframe_t *frame)
+{
+    SDL_Rect    rect = { 0, 0, SCREENWIDTH, frame->height };
+
+    if (!frame->motionblur && !I_ExpandScreen(frame->pixels, frame->pallut, &rect))
+    {
+        int y;
+
+        for (y = 0; y < rect.h; y++)
+            expandrowfunc(frame->pixels + y * SCREENWIDTH, frame->blended + y * SCREENWIDTH,
+                SCREENWIDTH, frame->pallut);
+
+        frame->motionblur = true;
+    }
+
+    if (frame->motionblur)
+        SDL_UpdateTexture(texture, &rect, frame->blended, SCREENWIDTH * 4);
+
+    if (vid_pillarboxes)
+        SDL_SetRenderDrawColor(renderer, (frame->pallut[0] >> 16) & 0xFF, (frame->pallut[0] >> 8) & 0xFF,
+            frame->pallut[0] & 0xFF, SDL_ALPHA_OPAQUE);
+
+    SDL_RenderClear(renderer);
+
+    if (nearestlinear)
+        SDL_SetRenderTarget(renderer, texture_upscaled);
+
+    if (frame->angle)
+        SDL_RenderCopyEx(renderer, texture, &rect, NULL, frame->angle, NULL, SDL_FLIP_NONE);
+    else
+        SDL_RenderCopy(renderer, texture, &rect, NULL);
+
+    if (nearestlinear)
+    {
+        SDL_SetRenderTarget(renderer, NULL);
+        SDL_RenderCopy(renderer, texture_upscaled, NULL, NULL);
+    }
+
+    I_PaceFrame();
 
     SDL_RenderPresent(renderer);
 }
 
+static int I_PresentThread(void *data)
+{
+    while (true)
+    {
+        SDL_SemWait(presentsem);
+
+        SDL_LockMutex(presentframelock);
+
+        if (presentquit)
+        {
+            SDL_UnlockMutex(presentframelock);
+            break;
+        }
+
+        presenting = presentready;
+        presentready = -1;
+        SDL_UnlockMutex(presentframelock);
+
+        // [BH] the frame posted may have already been replaced and presented
+        if (presenting == -1)
+            continue;
+
+        I_LockRenderer();
+        I_PresentFrame(&presentframes[presenting]);
+        I_UnlockRenderer();
+
+        SDL_LockMutex(presentframelock);
+        presenting = -1;
+        SDL_UnlockMutex(presentframelock);
+    }
+
+    return 0;
+}
+
+static void I_Blit_Presenter(void)
+{
+    presentframe_t  *frame;
+    int             i = 0;
+
+    UpdateGrab();
+
+    if (vid_showfps)
+        CalculateFPS();
+
+    // [BH] find a frame that is neither waiting to be presented nor being presented
+    SDL_LockMutex(presentframelock);
+
+    while (i == presentready || i == presenting)
+        i++;
+
+    SDL_UnlockMutex(presentframelock);
+
+    frame = &presentframes[i];
+    frame->height = src_rect.h;
+    frame->angle = (blitshake ? M_RandomInt(-1000, 1000) / 1000.0 * r_shake_damage / 100.0 : 0.0);
+
+    // [BH] keep the palette the frame was rendered with, for its pillarboxes too
+    memcpy(frame->pallut, pallut, sizeof(pallut));
+
+    // [BH] motion blur blends each frame over the last one, so is done here instead
+    if ((frame->motionblur = motionblur))
+    {
+        SDL_LowerBlit(surface, &src_rect, buffer, &src_rect);
+        memcpy(frame->blended, buffer->pixels, SCREENWIDTH * 4 * src_rect.h);
+    }
+    else
+        memcpy(frame->pixels, screens[0], SCREENWIDTH * src_rect.h);
+
+    SDL_LockMutex(presentframelock);
+    presentready = i;
+    SDL_UnlockMutex(presentframelock);
+
+    SDL_SemPost(presentsem);
+}
+
+void I_StartPresenter(void)
+{
+    SDL_RendererInfo    rendererinfo;
+    int                 i;
+
+    if (presenter || !renderer)
+        return;
+
+    for (i = 0; i < NUMPRESENTFRAMES; i++)
+    {
+        presentframes[i].pixels = Z_Malloc(SCREENWIDTH * SCREENHEIGHT, PU_STATIC, NULL);
+        presentframes[i].blended = Z_Malloc(SCREENWIDTH * SCREENHEIGHT * 4, PU_STATIC, NULL);
+    }
+
+    rendererlock = SDL_CreateMutex();
+    presentframelock = SDL_CreateMutex();
+    presentsem = SDL_CreateSemaphore(0);
+    presentready = -1;
+    presenting = -1;
+    presentquit = false;
+
+    presentopengl = (!SDL_GetRendererInfo(renderer, &rendererinfo)
+        && M_StringStartsWith((char *)rendererinfo.name, vid_scaleapi_opengl));
+
+    // [BH] release the OpenGL context so the presenter thread can make it current
+    if (presentopengl)
+        SDL_GL_MakeCurrent(window, NULL);
+
+    if (!(presenter = SDL_CreateThread(I_PresentThread, "I_PresentThread", NULL)))
+    {
+        C_Warning("The presenter thread couldn't be created.");
+
+        SDL_DestroySemaphore(presentsem);
+        SDL_DestroyMutex(presentframelock);
+        SDL_DestroyMutex(rendererlock);
+        rendererlock = NULL;
+
+        for (i = 0; i < NUMPRESENTFRAMES; i++)
+        {
+            Z_Free(presentframes[i].pixels);
+            Z_Free(presentframes[i].blended);
+        }
+
+        return;
+    }
+
+    I_UpdateBlitFunc(blitshake);
+}
+
+void I_StopPresenter(void)
+{
+    int i;
+
+    if (!presenter)
+        return;
+
+    SDL_LockMutex(presentframelock);
+    presentquit = true;
+    SDL_UnlockMutex(presentframelock);
+
+    SDL_SemPost(presentsem);
+    SDL_WaitThread(presenter, NULL);
+    presenter = NULL;
+
+    SDL_DestroySemaphore(presentsem);
+    SDL_DestroyMutex(presentframelock);
+    SDL_DestroyMutex(rendererlock);
+    rendererlock = NULL;
+
+    for (i = 0; i < NUMPRESENTFRAMES; i++)
+    {
+        Z_Free(presentframes[i].pixels);
+        Z_Free(presentframes[i].blended);
+    }
+
+    I_UpdateBlitFunc(blitshake);
+}
+
 void I_UpdateBlitFunc(dboolean shake)
 {
-    if (shake)
+    blitshake = shake;
+
+    if (presenter)
+        blitfunc = I_Blit_Presenter;
+    else if (shake)
         blitfunc = (vid_showfps ? (nearestlinear ? I_Blit_NearestLinear_ShowFPS_Shake :
             I_Blit_ShowFPS_Shake) : (nearestlinear ? I_Blit_NearestLinear_Shake : I_Blit_Shake));
     else
@@ -968,11 +1338,17 @@ void I_SetPalette(byte *playpal)
         colors[i].r = gammatable[gammaindex][*playpal++];
         colors[i].g = gammatable[gammaindex][*playpal++];
         colors[i].b = gammatable[gammaindex][*playpal++];
+        pallut[i] = 0xFF000000u | ((Uint32)colors[i].r << 16) | ((Uint32)colors[i].g << 8) | colors[i].b;
     }
 
+    // [BH] there's no palette when running headless
+    if (!palette)
+        return;
+
     SDL_SetPaletteColors(palette, colors, 0, 256);
 
-    if (vid_pillarboxes)
+    // [BH] the presenter thread sets the color of the pillarboxes itself
+    if (vid_pillarboxes && !rendererlock)
         SDL_SetRenderDrawColor(renderer, palette[0].colors->r, palette[0].colors->g,
             palette[0].colors->b, SDL_ALPHA_OPAQUE);
 }
@@ -1294,6 +1670,13 @@ static void PositionOnCurrentDisplay(void)
 
 void I_SetMotionBlur(int percent)
 {
+    // [BH] the last frame was expanded straight into the texture, so blit it to the buffer first
+    //  for the next frame to be blended over
+    if (percent && !motionblur && surface)
+        SDL_LowerBlit(surface, &src_rect, buffer, &src_rect);
+
+    motionblur = !!percent;
+
     if (percent)
     {
         SDL_SetSurfaceAlphaMod(surface, SDL_ALPHA_OPAQUE - 128 * percent / 100);
@@ -1588,8 +1971,13 @@ static void SetVideoMode(dboolean output)
         }
         else
         {
+            SDL_DisplayMode     displaymode;
+
+            // [BH] if vsync isn't available, pace frames at the display's refresh rate instead
             if (vid_capfps)
                 I_CapFPS(vid_capfps);
+            else if (vid_vsync && !SDL_GetWindowDisplayMode(window, &displaymode) && displaymode.refresh_rate)
+                I_CapFPS((refreshrate = displaymode.refresh_rate));
 
             if (output)
             {
@@ -1603,6 +1991,8 @@ static void SetVideoMode(dboolean output)
 
                 if (vid_capfps)
                     C_Output("The framerate is capped at %s FPS.", commify(vid_capfps));
+                else if (refreshrate)
+                    C_Output("The framerate is capped at the display's refresh rate of %iHz.", refreshrate);
                 else
                     C_Output("The framerate is uncapped.");
             }
@@ -1679,6 +2069,15 @@ static void SetVideoMode(dboolean output)
 
 void I_ToggleWidescreen(dboolean toggle)
 {
+    if (!renderer)
+    {
+        vid_widescreen = toggle;
+        returntowidescreen = false;
+        return;
+    }
+
+    I_LockRenderer();
+
     if (toggle)
     {
         vid_widescreen = true;
@@ -1701,6 +2100,8 @@ void I_ToggleWidescreen(dboolean toggle)
         src_rect.h = SCREENHEIGHT;
     }
 
+    I_UnlockRenderer();
+
     returntowidescreen = false;
 
     if (SDL_SetPaletteColors(palette, colors, 0, 256) < 0)
@@ -1728,15 +2129,21 @@ void I_RestartGraphics(void)
     M_SetWindowCaption();
 
     forceconsoleblurredraw = true;
+
+    if (vid_presentthread)
+        I_StartPresenter();
 }
 
 void I_ToggleFullscreen(void)
 {
     dboolean    fullscreen = !vid_fullscreen;
 
+    I_LockRenderer();
+
     if (!M_StringCompare(vid_screenresolution, vid_screenresolution_desktop)
         || SDL_SetWindowFullscreen(window, (fullscreen ? SDL_WINDOW_FULLSCREEN_DESKTOP : 0)) < 0)
     {
+        I_UnlockRenderer();
         menuactive = false;
         C_ShowConsole();
         C_Warning("Unable to switch to %s mode.", (fullscreen ? "fullscreen" : "windowed"));
@@ -1764,6 +2171,8 @@ void I_ToggleFullscreen(void)
         if (menuactive || consoleactive || paused || gamestate != GS_LEVEL)
             SDL_WarpMouseInWindow(window, windowwidth - 10 * windowwidth / SCREENWIDTH, windowheight - 16);
     }
+
+    I_UnlockRenderer();
 }
 
 static void I_InitGammaTables(void)
@@ -1842,6 +2251,11 @@ void I_InitGraphics(void)
 
     SDL_DisableScreenSaver();
 
+#if defined(SIMDBLIT)
+    if (SDL_HasAVX2())
+        expandrowfunc = I_ExpandRowAVX2;
+#endif
+
     while (i < UCHAR_MAX)
         keys[i++] = true;
     keys['v'] = keys['V'] = false;
@@ -1896,4 +2310,25 @@ void I_InitGraphics(void)
     while (SDL_PollEvent(&dummy));
 
     UpdateGrab();
+    if (vid_presentthread)
+        I_StartPresenter();
+}
+
+//
+// I_InitHeadlessGraphics
+// [BH] Do everything I_InitGraphics() does that the renderer needs, but without
+//  creating a window, so frames can be rendered into screens[0] by -benchmark.
+//
+void I_InitHeadlessGraphics(void)
+{
+    playpal = W_CacheLumpName("PLAYPAL", PU_CACHE);
+    I_InitTintTables(playpal);
+    FindNearestColors(playpal);
+
+    I_InitGammaTables();
+
+    mapscreen = Z_Malloc(SCREENWIDTH * SCREENHEIGHT, PU_STATIC, NULL);
+
+    blitfunc = nullfunc;
+    mapblitfunc = nullfunc;
 }
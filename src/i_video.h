@@ -60,6 +60,7 @@ void I_InitKeyboard(void);
 // determines the hardware configuration
 // and sets up the video mode
 void I_InitGraphics(void);
+void I_InitHeadlessGraphics(void);
 void I_RestartGraphics(void);
 void I_ShutdownGraphics(void);
 
@@ -73,6 +74,10 @@ void I_ShutdownKeyboard(void);
 void I_SetPalette(byte *palette);
 
 void I_UpdateBlitFunc(dboolean shake);
+void I_StartPresenter(void);
+void I_StopPresenter(void);
+void I_LockRenderer(void);
+void I_UnlockRenderer(void);
 void I_Blit_Automap(void);
 void I_CreateExternalAutomap(dboolean output);
 void I_DestroyExternalAutomap(void);
@@ -117,7 +122,9 @@ void (*mapblitfunc)(void);
 
 extern dboolean         vid_fullscreen;
 extern int              vid_motionblur;
+extern dboolean         vid_presentthread;
 extern dboolean         vid_showfps;
+extern dboolean         vid_showprofile;
 extern dboolean         wipe;
 
 extern int              windowx;
@@ -126,6 +126,7 @@ extern dboolean         r_shadows;
 extern dboolean         r_shake_barrels;
 extern int              r_shake_damage;
 extern int              r_skycolor;
+extern int              r_strips;
 extern dboolean         r_textures;
 extern dboolean         r_translucency;
 extern int              s_musicvolume;
@@ -134,7 +135,9 @@ extern dboolean         s_randompitch;
 extern int              s_sfxvolume;
 extern char             *s_timiditycfgpath;
 extern int              savegameselected;
+extern dboolean         savethread;
 extern int              skilllevelselected;
+extern dboolean         sleepthinkers;
 extern int              stillbob;
 extern unsigned int     stat_barrelsexploded;
 extern unsigned int     stat_cheated;
@@ -184,6 +187,7 @@ extern char             *vid_driver;
 extern dboolean         vid_fullscreen;
 extern int              vid_motionblur;
 extern dboolean         vid_pillarboxes;
+extern dboolean         vid_presentthread;
 extern char             *vid_scaleapi;
 extern char             *vid_scalefilter;
 extern char             *vid_screenresolution;
@@ -301,6 +305,7 @@ static default_t cvars[] =
     CONFIG_VARIABLE_INT          (r_shake_barrels,                                   BOOLVALUEALIAS  ),
     CONFIG_VARIABLE_INT_PERCENT  (r_shake_damage,                                    NOVALUEALIAS    ),
     CONFIG_VARIABLE_INT          (r_skycolor,                                        SKYVALUEALIAS   ),
+    CONFIG_VARIABLE_INT          (r_strips,                                          NOVALUEALIAS    ),
     CONFIG_VARIABLE_INT          (r_textures,                                        BOOLVALUEALIAS  ),
     CONFIG_VARIABLE_INT          (r_translucency,                                    BOOLVALUEALIAS  ),
     CONFIG_VARIABLE_INT_PERCENT  (s_musicvolume,                                     NOVALUEALIAS    ),
@@ -309,7 +314,9 @@ static default_t cvars[] =
     CONFIG_VARIABLE_INT_PERCENT  (s_sfxvolume,                                       NOVALUEALIAS    ),
     CONFIG_VARIABLE_STRING       (s_timiditycfgpath,                                 NOVALUEALIAS    ),
     CONFIG_VARIABLE_INT          (savegameselected,                                  NOVALUEALIAS    ),
+    CONFIG_VARIABLE_INT          (savethread,                                        BOOLVALUEALIAS  ),
     CONFIG_VARIABLE_INT          (skilllevelselected,                                NOVALUEALIAS    ),
+    CONFIG_VARIABLE_INT          (sleepthinkers,                                     BOOLVALUEALIAS  ),
     CONFIG_VARIABLE_INT_PERCENT  (stillbob,                                          NOVALUEALIAS    ),
     CONFIG_VARIABLE_INT_PERCENT  (turbo,                                             NOVALUEALIAS    ),
     CONFIG_VARIABLE_INT          (units,                                             UNITSVALUEALIAS ),
@@ -322,6 +329,7 @@ static default_t cvars[] =
     CONFIG_VARIABLE_INT          (vid_fullscreen,                                    BOOLVALUEALIAS  ),
     CONFIG_VARIABLE_INT_PERCENT  (vid_motionblur,                                    NOVALUEALIAS    ),
     CONFIG_VARIABLE_INT          (vid_pillarboxes,                                   BOOLVALUEALIAS  ),
+    CONFIG_VARIABLE_INT          (vid_presentthread,                                 BOOLVALUEALIAS  ),
     CONFIG_VARIABLE_STRING       (vid_scaleapi,                                      NOVALUEALIAS    ),
     CONFIG_VARIABLE_STRING       (vid_scalefilter,                                   NOVALUEALIAS    ),
     CONFIG_VARIABLE_OTHER        (vid_screenresolution,                              NOVALUEALIAS    ),
@@ -837,6 +845,8 @@ static void M_CheckCVARs(void)
     if (r_skycolor != r_skycolor_none && (r_skycolor < r_skycolor_min || r_skycolor > r_skycolor_max))
         r_skycolor = r_skycolor_default;
 
+    r_strips = BETWEEN(r_strips_min, r_strips, r_strips_max);
+
     if (r_textures != false && r_textures != true)
         r_textures = r_textures_default;
 
@@ -857,8 +867,14 @@ static void M_CheckCVARs(void)
 
     savegameselected = BETWEEN(savegameselected_min, savegameselected, savegameselected_max);
 
+    if (savethread != false && savethread != true)
+        savethread = savethread_default;
+
     skilllevelselected = BETWEEN(skilllevelselected_min, skilllevelselected, skilllevelselected_max);
 
+    if (sleepthinkers != false && sleepthinkers != true)
+        sleepthinkers = sleepthinkers_default;
+
     stillbob = BETWEEN(stillbob_min, stillbob, stillbob_max);
 
     turbo = BETWEEN(turbo_min, turbo, turbo_max);
@@ -875,6 +891,9 @@ static void M_CheckCVARs(void)
 
     vid_motionblur = BETWEEN(vid_motionblur_min, vid_motionblur, vid_motionblur_max);
 
+    if (vid_presentthread != false && vid_presentthread != true)
+        vid_presentthread = vid_presentthread_default;
+
     if (!M_StringCompare(vid_scaleapi, vid_scaleapi_direct3d)
         && !M_StringCompare(vid_scaleapi, vid_scaleapi_opengl)
 #if !defined(_WIN32)
@@ -311,10 +311,22 @@ typedef enum
 #define r_skycolor_default                      r_skycolor_none
 #define r_skycolor_max                          255
 
+#define r_strips_min                            1
+#define r_strips_default                        1
+#define r_strips_max                            16
+
 #define r_textures_default                      true
 
 #define r_translucency_default                  true
 
+#define r_visplanes_bytes_min                   0
+#define r_visplanes_bytes_default               0
+#define r_visplanes_bytes_max                   0
+
+#define r_visplanes_total_min                   0
+#define r_visplanes_total_default               0
+#define r_visplanes_total_max                   0
+
 #define s_musicvolume_min                       0
 #define s_musicvolume_default                   67
 #define s_musicvolume_max                       100
@@ -335,12 +347,16 @@ typedef enum
 #define savegameselected_default                0
 #define savegameselected_max                    5
 
+#define savethread_default                      false
+
 #define skilllevel_default                      ""
 
 #define skilllevelselected_min                  sk_baby
 #define skilllevelselected_default              sk_medium
 #define skilllevelselected_max                  sk_nightmare
 
+#define sleepthinkers_default                   false
+
 #define stillbob_min                            0
 #define stillbob_default                        0
 #define stillbob_max                            100
@@ -373,6 +389,8 @@ typedef enum
 
 #define vid_pillarboxes_default                 false
 
+#define vid_presentthread_default               false
+
 #define vid_scaleapi_direct3d                   "direct3d"
 #define vid_scaleapi_opengl                     "opengl"
 #if !defined(_WIN32)
@@ -392,6 +410,8 @@ typedef enum
 
 #define vid_showfps_default                     false
 
+#define vid_showprofile_default                 false
+
 #define vid_vsync_default                       true
 
 #define vid_widescreen_default                  false
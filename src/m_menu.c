@@ -835,6 +835,9 @@ void M_ReadSaveStrings(void)
     int         i;
     char        name[256];
 
+    // [BH] the savegame might still be being written
+    G_WaitForSaveGame();
+
     for (i = 0; i < load_end; i++)
     {
         FILE    *handle;
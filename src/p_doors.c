@@ -368,7 +368,7 @@ dboolean EV_DoDoor(line_t *line, vldoor_e type)
 
         // new door thinker
         rtn = true;
-        door = Z_Calloc(1, sizeof(*door), PU_LEVSPEC, NULL);
+        door = Z_PoolCalloc(&doorpool, PU_LEVSPEC, NULL);
         P_AddThinker(&door->thinker);
         sec->ceilingdata = door;
 
@@ -629,7 +629,7 @@ void EV_VerticalDoor(line_t *line, mobj_t *thing)
     }
 
     // new door thinker
-    door = Z_Calloc(1, sizeof(*door), PU_LEVSPEC, NULL);
+    door = Z_PoolCalloc(&doorpool, PU_LEVSPEC, NULL);
     P_AddThinker(&door->thinker);
     sec->ceilingdata = door;
     door->thinker.function = T_VerticalDoor;
@@ -689,7 +689,7 @@ void EV_VerticalDoor(line_t *line, mobj_t *thing)
 //
 void P_SpawnDoorCloseIn30(sector_t *sec)
 {
-    vldoor_t    *door = Z_Calloc(1, sizeof(*door), PU_LEVSPEC, NULL);
+    vldoor_t    *door = Z_PoolCalloc(&doorpool, PU_LEVSPEC, NULL);
 
     P_AddThinker(&door->thinker);
 
@@ -711,7 +711,7 @@ void P_SpawnDoorCloseIn30(sector_t *sec)
 //
 void P_SpawnDoorRaiseIn5Mins(sector_t *sec)
 {
-    vldoor_t    *door = Z_Calloc(1, sizeof(*door), PU_LEVSPEC, NULL);
+    vldoor_t    *door = Z_PoolCalloc(&doorpool, PU_LEVSPEC, NULL);
 
     P_AddThinker(&door->thinker);
 
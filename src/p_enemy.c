@@ -105,44 +105,142 @@ extern unsigned int     stat_monsterskilled;
 //
 
 //
-// P_RecursiveSound
-// Called by P_NoiseAlert.
-// Recursively traverse adjacent sectors,
-// sound blocking lines cut off traversal.
+// [BH] SOUND PROPAGATION
+// The two-sided lines of each sector are gathered into a graph when a map is loaded, so
+//  P_NoiseAlert() can flood through it without checking every line of every sector it
+//  reaches. Whether each line is open is kept up to date by P_UpdateSoundGraph() as
+//  sectors change height.
 //
-// killough 5/5/98: reformatted, cleaned up
+typedef struct
+{
+    int                 sector;
+    int                 line;
+    dboolean            soundblock;
+} soundedge_t;
+
+static soundedge_t      *soundedges;
+static int              *firstsoundedge;
+static byte             *soundlineopen;
+static int              *soundqueue;
+
 //
-static void P_RecursiveSound(sector_t *sec, int soundblocks, mobj_t *soundtarget)
+// P_IsSoundLineOpen
+// The same test for a closed door as P_LineOpening(), without changing opentop,
+//  openbottom, openrange and lowfloor.
+//
+static dboolean P_IsSoundLineOpen(const line_t *line)
 {
-    int i;
+    const sector_t  *front = line->frontsector;
+    const sector_t  *back = line->backsector;
 
-    // wake up all monsters in this sector
-    if (sec->validcount == validcount && sec->soundtraversed <= soundblocks + 1)
-        return;         // already flooded
+    if (line->sidenum[1] == NO_INDEX)
+        return false;
 
-    sec->validcount = validcount;
-    sec->soundtraversed = soundblocks + 1;
-    P_SetTarget(&sec->soundtarget, soundtarget);
+    return (MIN(front->ceilingheight, back->ceilingheight)
+        - MAX(front->floorheight, back->floorheight) > 0);
+}
+
+//
+// P_BuildSoundGraph
+// Called when a map is loaded, or a savegame is loaded.
+//
+void P_BuildSoundGraph(void)
+{
+    int i, j;
+    int numedges = 0;
+
+    if (soundedges)
+    {
+        Z_Free(soundedges);
+        Z_Free(firstsoundedge);
+        Z_Free(soundlineopen);
+        Z_Free(soundqueue);
+    }
+
+    firstsoundedge = Z_Malloc((numsectors + 1) * sizeof(*firstsoundedge), PU_LEVEL,
+        (void **)&firstsoundedge);
+
+    for (i = 0; i < numsectors; i++)
+    {
+        firstsoundedge[i] = numedges;
+
+        for (j = 0; j < sectors[i].linecount; j++)
+            if (sectors[i].lines[j]->flags & ML_TWOSIDED)
+                numedges++;
+    }
+
+    firstsoundedge[numsectors] = numedges;
+    soundedges = Z_Malloc(MAX(1, numedges) * sizeof(*soundedges), PU_LEVEL, (void **)&soundedges);
+
+    for (i = 0, numedges = 0; i < numsectors; i++)
+    {
+        sector_t    *sec = &sectors[i];
+
+        for (j = 0; j < sec->linecount; j++)
+        {
+            line_t  *check = sec->lines[j];
+
+            if (check->flags & ML_TWOSIDED)
+            {
+                soundedge_t *edge = &soundedges[numedges++];
+
+                edge->sector = (int)(sides[check->sidenum[(sides[check->sidenum[0]].sector == sec)]].sector
+                    - sectors);
+                edge->line = (int)(check - lines);
+                edge->soundblock = !!(check->flags & ML_SOUNDBLOCK);
+            }
+        }
+    }
+
+    soundlineopen = Z_Malloc(MAX(1, numlines), PU_LEVEL, (void **)&soundlineopen);
+
+    for (i = 0; i < numlines; i++)
+        soundlineopen[i] = P_IsSoundLineOpen(&lines[i]);
+
+    soundqueue = Z_Malloc(MAX(1, numsectors) * sizeof(*soundqueue), PU_LEVEL, (void **)&soundqueue);
+}
+
+//
+// P_UpdateSoundGraph
+// Called whenever the floor or ceiling of sector moves.
+//
+void P_UpdateSoundGraph(sector_t *sector)
+{
+    int i;
 
-    for (i = 0; i < sec->linecount; i++)
+    if (!soundlineopen)
+        return;
+
+    for (i = 0; i < sector->linecount; i++)
     {
-        sector_t        *other;
-        line_t          *check = sec->lines[i];
+        line_t  *line = sector->lines[i];
 
-        if (!(check->flags & ML_TWOSIDED))
-            continue;
+        if (line->flags & ML_TWOSIDED)
+            soundlineopen[line - lines] = P_IsSoundLineOpen(line);
+    }
+}
 
-        P_LineOpening(check);
+//
+// P_FloodSound
+// Wake up all monsters in sector.
+//
+static void P_FloodSound(int sector, int soundtraversed, mobj_t *soundtarget, int *tail)
+{
+    sector_t    *sec = &sectors[sector];
 
-        if (openrange <= 0)
-            continue;   // closed door
+    sec->validcount = validcount;
+    sec->soundtraversed = soundtraversed;
+    P_SetTarget(&sec->soundtarget, soundtarget);
+    soundqueue[(*tail)++] = sector;
 
-        other = sides[check->sidenum[(sides[check->sidenum[0]].sector == sec)]].sector;
+    // [BH] wake monsters that were sleeping in A_Look()
+    if (sleepingthinkers)
+    {
+        mobj_t  *mo;
 
-        if (!(check->flags & ML_SOUNDBLOCK))
-            P_RecursiveSound(other, soundblocks, soundtarget);
-        else if (!soundblocks)
-            P_RecursiveSound(other, 1, soundtarget);
+        for (mo = sec->thinglist; mo; mo = mo->snext)
+            if (mo->tics != -1)
+                P_WakeMobj(mo);
     }
 }
 
@@ -151,14 +249,68 @@ static void P_RecursiveSound(sector_t *sec, int soundblocks, mobj_t *soundtarget
 // If a monster yells at a player,
 // it will alert other monsters to the player.
 //
+// [BH] Sound blocking lines cut off traversal. This floods first through every sector
+//  that can be reached without crossing one, and then through those that can be reached
+//  by crossing only one, which leaves each sector as P_RecursiveSound() did.
+//
 void P_NoiseAlert(mobj_t *target, mobj_t *emmiter)
 {
+    int head = 0;
+    int tail = 0;
+    int unblocked;
+    int i;
+
     // [BH] don't alert if notarget is enabled
     if (players[0].cheats & CF_NOTARGET)
         return;
 
     validcount++;
-    P_RecursiveSound(emmiter->subsector->sector, 0, target);
+    P_FloodSound((int)(emmiter->subsector->sector - sectors), 1, target, &tail);
+
+    while (head < tail)
+    {
+        int sector = soundqueue[head++];
+
+        for (i = firstsoundedge[sector]; i < firstsoundedge[sector + 1]; i++)
+        {
+            soundedge_t *edge = &soundedges[i];
+
+            if (!edge->soundblock && soundlineopen[edge->line]
+                && sectors[edge->sector].validcount != validcount)
+                P_FloodSound(edge->sector, 1, target, &tail);
+        }
+    }
+
+    // cross one sound blocking line
+    unblocked = tail;
+
+    for (head = 0; head < unblocked; head++)
+    {
+        int sector = soundqueue[head];
+
+        for (i = firstsoundedge[sector]; i < firstsoundedge[sector + 1]; i++)
+        {
+            soundedge_t *edge = &soundedges[i];
+
+            if (edge->soundblock && soundlineopen[edge->line]
+                && sectors[edge->sector].validcount != validcount)
+                P_FloodSound(edge->sector, 2, target, &tail);
+        }
+    }
+
+    while (head < tail)
+    {
+        int sector = soundqueue[head++];
+
+        for (i = firstsoundedge[sector]; i < firstsoundedge[sector + 1]; i++)
+        {
+            soundedge_t *edge = &soundedges[i];
+
+            if (!edge->soundblock && soundlineopen[edge->line]
+                && sectors[edge->sector].validcount != validcount)
+                P_FloodSound(edge->sector, 2, target, &tail);
+        }
+    }
 }
 
 //
@@ -1028,8 +1180,10 @@ void A_PosAttack(mobj_t *actor, player_t *player, pspdef_t *psp)
     A_FaceTarget(actor, NULL, NULL);
 
     S_StartSound(actor, sfx_pistol);
+    P_StartHitscanBatch(actor, 255 << 20);
     P_LineAttack(actor, actor->angle + ((M_Random() - M_Random()) << 20), MISSILERANGE,
         P_AimLineAttack(actor, actor->angle, MISSILERANGE), ((M_Random() % 5) + 1) * 3);
+    P_EndHitscanBatch();
 }
 
 void A_SPosAttack(mobj_t *actor, player_t *player, pspdef_t *psp)
@@ -1042,9 +1196,13 @@ void A_SPosAttack(mobj_t *actor, player_t *player, pspdef_t *psp)
     A_FaceTarget(actor, NULL, NULL);
 
     S_StartSound(actor, sfx_shotgn);
+    P_StartHitscanBatch(actor, 255 << 20);
+
     for (i = 0; i < 3; i++)
         P_LineAttack(actor, actor->angle + ((M_Random() - M_Random()) << 20), MISSILERANGE,
             P_AimLineAttack(actor, actor->angle, MISSILERANGE), ((M_Random() % 5) + 1) * 3);
+
+    P_EndHitscanBatch();
 }
 
 void A_CPosAttack(mobj_t *actor, player_t *player, pspdef_t *psp)
@@ -1055,8 +1213,10 @@ void A_CPosAttack(mobj_t *actor, player_t *player, pspdef_t *psp)
     A_FaceTarget(actor, NULL, NULL);
 
     S_StartSound(actor, sfx_shotgn);
+    P_StartHitscanBatch(actor, 255 << 20);
     P_LineAttack(actor, actor->angle + ((M_Random() - M_Random()) << 20), MISSILERANGE,
         P_AimLineAttack(actor, actor->angle, MISSILERANGE), ((M_Random() % 5) + 1) * 3);
+    P_EndHitscanBatch();
 }
 
 void A_CPosRefire(mobj_t *actor, player_t *player, pspdef_t *psp)
@@ -1201,6 +1361,7 @@ void A_SkelMissile(mobj_t *actor, player_t *player, pspdef_t *psp)
 
     mo->x += mo->momx;
     mo->y += mo->momy;
+    P_UpdateBlockThing(mo);
     P_SetTarget(&mo->tracer, actor->target);
 }
 
@@ -60,6 +60,9 @@ result_e T_MovePlane(sector_t *sector, fixed_t speed, fixed_t dest, dboolean cru
 
     sector->oldgametic = gametic;
 
+    // [BH] sight checks made before the sector moved may no longer hold
+    P_ClearSightCache();
+
     switch (floorOrCeiling)
     {
         case 0:
@@ -358,7 +361,7 @@ dboolean EV_DoFloor(line_t *line, floor_e floortype)
 
         // new floor thinker
         rtn = true;
-        floor = Z_Calloc(1, sizeof(*floor), PU_LEVSPEC, NULL);
+        floor = Z_PoolCalloc(&floorpool, PU_LEVSPEC, NULL);
         P_AddThinker(&floor->thinker);
         sec->floordata = floor;
         floor->thinker.function = T_MoveFloor;
@@ -650,7 +653,7 @@ dboolean EV_BuildStairs(line_t *line, stair_e type)
 
         // new floor thinker
         rtn = true;
-        floor = Z_Calloc(1, sizeof(*floor), PU_LEVSPEC, NULL);
+        floor = Z_PoolCalloc(&floorpool, PU_LEVSPEC, NULL);
         P_AddThinker(&floor->thinker);
         sec->floordata = floor;
         floor->thinker.function = T_MoveFloor;
@@ -719,7 +722,7 @@ dboolean EV_BuildStairs(line_t *line, stair_e type)
 
                 sec = tsec;
                 secnum = newsecnum;
-                floor = Z_Calloc(1, sizeof(*floor), PU_LEVSPEC, NULL);
+                floor = Z_PoolCalloc(&floorpool, PU_LEVSPEC, NULL);
                 P_AddThinker(&floor->thinker);
 
                 sec->floordata = floor;
@@ -766,7 +769,7 @@ dboolean EV_DoElevator(line_t *line, elevator_e elevtype)
 
         // create and initialize new elevator thinker
         rtn = true;
-        elevator = Z_Calloc(1, sizeof(*elevator), PU_LEVSPEC, NULL);
+        elevator = Z_PoolCalloc(&elevatorpool, PU_LEVSPEC, NULL);
         P_AddThinker(&elevator->thinker);
         sec->floordata = elevator;
         sec->ceilingdata = elevator;
@@ -1131,6 +1131,8 @@ void P_KillMobj(mobj_t *target, mobj_t *inflicter, mobj_t *source)
     int         gibhealth;
     player_t    *player = &players[0];
 
+    P_WakeMobj(target);
+
     target->flags &= ~(MF_SHOOTABLE | MF_FLOAT | MF_SKULLFLY);
 
     if (type == MT_SKULL)
@@ -1304,6 +1306,8 @@ void P_DamageMobj(mobj_t *target, mobj_t *inflicter, mobj_t *source, int damage,
     if (type == MT_BARREL && corpse)
         return;
 
+    P_WakeMobj(target);
+
     if (flags & MF_SKULLFLY)
     {
         target->momx = 0;
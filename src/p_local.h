@@ -138,6 +138,10 @@ mobjtype_t P_FindDoomedNum(unsigned int type);
 void P_RemoveMobj(mobj_t *th);
 dboolean P_SetMobjState(mobj_t *mobj, statenum_t state);
 void P_MobjThinker(mobj_t *mobj);
+void P_CatchUpMobj(mobj_t *mobj);
+void P_WakeMobj(mobj_t *mobj);
+void P_WakeMobjs(void);
+void P_WakeLookingMobjs(void);
 
 void P_SpawnPuff(fixed_t x, fixed_t y, fixed_t z, angle_t angle);
 void P_SpawnSmokeTrail(fixed_t x, fixed_t y, fixed_t z, angle_t angle);
@@ -151,6 +155,8 @@ void P_InitExtraMobjs(void);
 //
 // P_ENEMY
 //
+void P_BuildSoundGraph(void);
+void P_UpdateSoundGraph(sector_t *sector);
 void P_NoiseAlert(mobj_t *target, mobj_t *emmiter);
 
 //
@@ -190,19 +196,27 @@ void P_LineOpening(line_t *linedef);
 
 dboolean P_BlockLinesIterator(int x, int y, dboolean func(line_t *));
 dboolean P_BlockThingsIterator(int x, int y, dboolean func(mobj_t *));
+dboolean P_BlockThingsBoxIterator(int x, int y, const fixed_t *box, dboolean func(mobj_t *));
 
 #define PT_ADDLINES     1
 #define PT_ADDTHINGS    2
 
 extern divline_t        dlTrace;
+extern int              pathtraversecalls;
 
+void P_StartHitscanBatch(mobj_t *source, angle_t spread);
+void P_EndHitscanBatch(void);
 dboolean P_PathTraverse(fixed_t x1, fixed_t y1, fixed_t x2, fixed_t y2, int flags,
     dboolean (*trav)(intercept_t *));
 
 void P_UnsetThingPosition(mobj_t *thing);
-void P_UnsetBloodSplatPosition(bloodsplat_t *splat);
 void P_SetThingPosition(mobj_t *thing);
-void P_SetBloodSplatPosition(bloodsplat_t *splat);
+void P_UpdateBlockThing(mobj_t *thing);
+void P_FreeBlockThings(void);
+void P_SetBloodSplatPosition(const bloodsplat_t *splat, sector_t *sector);
+void P_RemoveBloodSplats(sector_t *sector);
+void P_ResizeBloodSplatRing(void);
+void P_FreeBloodSplats(void);
 
 //
 // P_MAP
@@ -220,6 +234,7 @@ extern line_t           *ceilingline;
 extern line_t           *blockline;
 
 extern dboolean         infight;
+extern int              trymovecalls;
 
 dboolean P_CheckPosition(mobj_t *thing, fixed_t x, fixed_t y);
 mobj_t *P_CheckOnmobj(mobj_t *thing);
@@ -229,6 +244,12 @@ dboolean P_CheckLineSide(mobj_t *actor, fixed_t x, fixed_t y);
 dboolean P_TeleportMove(mobj_t *thing, fixed_t x, fixed_t y, fixed_t z, dboolean boss);
 void P_SlideMove(mobj_t *mo);
 dboolean P_CheckSight(mobj_t *t1, mobj_t *t2);
+void P_ClearSightCache(void);
+void P_ResetSightCache(void);
+
+extern int              sightcachehits;
+extern int              sightcachemisses;
+extern int              checksightcalls;
 void P_UseLines(player_t *player);
 
 dboolean P_ChangeSector(sector_t *sector, dboolean crunch);
@@ -258,7 +279,24 @@ extern int              bmapwidth;
 extern int              bmapheight;     // in mapblocks
 extern fixed_t          bmaporgx;
 extern fixed_t          bmaporgy;       // origin of block map
-extern mobj_t           **blocklinks;   // for thing chains
+
+// [BH] the things in a block of the blockmap
+typedef struct
+{
+    fixed_t             x;
+    fixed_t             y;
+    fixed_t             radius;
+    mobj_t              *mobj;
+} blockthing_t;
+
+typedef struct
+{
+    blockthing_t        *things;
+    int                 numthings;
+    int                 maxthings;
+} blockthings_t;
+
+extern blockthings_t    *blockthings;
 
 //
 // P_INTER
@@ -88,6 +88,9 @@ dboolean                infight;
 
 mobj_t                  *onmobj;
 
+// [BH] counted for -simulate
+int                     trymovecalls;
+
 unsigned int            stat_distancetraveled;
 
 extern dboolean         successfulshot;
@@ -258,7 +261,7 @@ dboolean P_TeleportMove(mobj_t *thing, fixed_t x, fixed_t y, fixed_t z, dboolean
 
     for (bx = xl; bx <= xh; bx++)
         for (by = yl; by <= yh; by++)
-            if (!P_BlockThingsIterator(bx, by, PIT_StompThing))
+            if (!P_BlockThingsBoxIterator(bx, by, tmbbox, PIT_StompThing))
                 return false;
 
     // the move is ok,
@@ -428,6 +431,7 @@ dboolean PIT_CheckThing(mobj_t *thing)
     if (r_corpses_nudge && (flags & MF_CORPSE) && (tmflags & MF_SHOOTABLE) && !thing->nudge
         && dist < 16 * FRACUNIT && thing->z == tmthing->z)
     {
+        P_WakeMobj(thing);
         thing->nudge = TICRATE;
         if (thing->flags2 & MF2_FEETARECLIPPED)
         {
@@ -694,6 +698,7 @@ dboolean P_CheckPosition(mobj_t *thing, fixed_t x, fixed_t y)
     int         by;
     subsector_t *newsubsec;
     fixed_t     radius = thing->radius;
+    fixed_t     box[4];
 
     tmthing = thing;
 
@@ -735,9 +740,15 @@ dboolean P_CheckPosition(mobj_t *thing, fixed_t x, fixed_t y)
     yl = (tmbbox[BOXBOTTOM] - bmaporgy - MAXRADIUS) >> MAPBLOCKSHIFT;
     yh = (tmbbox[BOXTOP] - bmaporgy + MAXRADIUS) >> MAPBLOCKSHIFT;
 
+    // [BH] include any corpses close enough to where the thing is now to be nudged
+    box[BOXTOP] = MAX(tmbbox[BOXTOP], thing->y + 16 * FRACUNIT);
+    box[BOXBOTTOM] = MIN(tmbbox[BOXBOTTOM], thing->y - 16 * FRACUNIT);
+    box[BOXRIGHT] = MAX(tmbbox[BOXRIGHT], thing->x + 16 * FRACUNIT);
+    box[BOXLEFT] = MIN(tmbbox[BOXLEFT], thing->x - 16 * FRACUNIT);
+
     for (bx = xl; bx <= xh; bx++)
         for (by = yl; by <= yh; by++)
-            if (!P_BlockThingsIterator(bx, by, PIT_CheckThing))
+            if (!P_BlockThingsBoxIterator(bx, by, box, PIT_CheckThing))
                 return false;
 
     // check lines
@@ -818,7 +829,7 @@ mobj_t *P_CheckOnmobj(mobj_t * thing)
 
     for (bx = xl; bx <= xh; bx++)
         for (by = yl; by <= yh; by++)
-            if (!P_BlockThingsIterator(bx, by, PIT_CheckOnmobjZ))
+            if (!P_BlockThingsBoxIterator(bx, by, tmbbox, PIT_CheckOnmobjZ))
             {
                 *tmthing = oldmo;
                 return onmobj;
@@ -891,6 +902,8 @@ dboolean P_TryMove(mobj_t *thing, fixed_t x, fixed_t y, dboolean dropoff)
     sector_t    *newsec;
     int         flags = thing->flags;
 
+    trymovecalls++;
+
     felldown = false;           // killough 11/98
     floatok = false;
 
@@ -1863,14 +1876,20 @@ void P_RadiusAttack(mobj_t *spot, mobj_t *source, int damage)
     int         yl = (spot->y - dist - bmaporgy) >> MAPBLOCKSHIFT;
     int         xh = (spot->x + dist - bmaporgx) >> MAPBLOCKSHIFT;
     int         xl = (spot->x - dist - bmaporgx) >> MAPBLOCKSHIFT;
+    fixed_t     box[4];
 
     bombspot = spot;
     bombsource = source;
     bombdamage = damage;
 
+    box[BOXTOP] = spot->y + (damage << FRACBITS);
+    box[BOXBOTTOM] = spot->y - (damage << FRACBITS);
+    box[BOXRIGHT] = spot->x + (damage << FRACBITS);
+    box[BOXLEFT] = spot->x - (damage << FRACBITS);
+
     for (y = yl; y <= yh; y++)
         for (x = xl; x <= xh; x++)
-            P_BlockThingsIterator(x, y, PIT_RadiusAttack);
+            P_BlockThingsBoxIterator(x, y, box, PIT_RadiusAttack);
 }
 
 //
@@ -1898,6 +1917,8 @@ void PIT_ChangeSector(mobj_t *thing)
     int flags = thing->flags;
     int flags2 = thing->flags2;
 
+    P_WakeMobj(thing);
+
     if (isliquidsector && !(flags2 & MF2_NOFOOTCLIP) && !(thing->info->flags & MF_SPAWNCEILING))
         thing->flags2 |= MF2_FEETARECLIPPED;
     else
@@ -1973,21 +1994,14 @@ dboolean P_ChangeSector(sector_t *sector, dboolean crunch)
 {
     msecnode_t  *n;
 
+    // [BH] the lines around the sector may have opened or closed
+    P_UpdateSoundGraph(sector);
+
     nofit = false;
     crushchange = crunch;
 
     if ((isliquidsector = sector->isliquid = isliquid[sector->floorpic]))
-    {
-        bloodsplat_t    *splat = sector->splatlist;
-
-        while (splat)
-        {
-            bloodsplat_t        *next = splat->snext;
-
-            P_UnsetBloodSplatPosition(splat);
-            splat = next;
-        }
-    }
+        P_RemoveBloodSplats(sector);
     else
     {
         sector->floor_xoffs = 0;
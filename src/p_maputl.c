@@ -36,11 +36,15 @@
 ========================================================================
 */
 
+#include "i_system.h"
 #include "m_bbox.h"
 #include "p_local.h"
 #include "p_setup.h"
 #include "z_zone.h"
 
+// [BH] incremented whenever a thing is linked into or out of the blockmap
+static unsigned int     blocklinksversion;
+
 extern msecnode_t       *sector_list;   // phares 3/16/98
 
 void P_CreateSecNodeList(mobj_t *thing, fixed_t x, fixed_t y);
@@ -188,6 +192,103 @@ void P_LineOpening(line_t *linedef)
 // THING POSITION SETTING
 //
 
+//
+// [BH] BLOCK THINGS
+// The things in each block of the blockmap are kept in an array, oldest first, along with
+//  a copy of the position of each and the largest radius any of the PIT_* functions will
+//  give it. The iterators can then reject most things without touching them at all.
+//
+static fixed_t P_BlockThingRadius(const mobj_t *thing)
+{
+    // a corpse being raised gets back the radius in its info
+    return MAX(thing->radius, MAX(thing->info->radius, thing->info->pickupradius));
+}
+
+static void P_LinkBlockThing(mobj_t *thing, int cell)
+{
+    blockthings_t   *block = &blockthings[cell];
+    blockthing_t    *blockthing;
+
+    if (block->numthings == block->maxthings)
+    {
+        block->maxthings = (block->maxthings ? block->maxthings * 2 : 8);
+        block->things = Z_Realloc(block->things, block->maxthings * sizeof(*block->things));
+    }
+
+    blockthing = &block->things[block->numthings++];
+    blockthing->x = thing->x;
+    blockthing->y = thing->y;
+    blockthing->radius = P_BlockThingRadius(thing);
+    blockthing->mobj = thing;
+    thing->blockcell = cell;
+}
+
+static void P_UnlinkBlockThing(mobj_t *thing)
+{
+    blockthings_t   *block;
+    int             i;
+
+    if (thing->blockcell < 0)
+        return;
+
+    block = &blockthings[thing->blockcell];
+    thing->blockcell = -1;
+
+    // things that move are usually the most recently linked
+    for (i = block->numthings - 1; i >= 0; i--)
+        if (block->things[i].mobj == thing)
+        {
+            // keep the rest in the order they were linked
+            memmove(&block->things[i], &block->things[i + 1],
+                (--block->numthings - i) * sizeof(*block->things));
+            break;
+        }
+}
+
+//
+// P_UpdateBlockThing
+// Called when a thing has been moved without being unlinked and linked again.
+//
+void P_UpdateBlockThing(mobj_t *thing)
+{
+    blockthings_t   *block;
+    int             i;
+
+    if ((thing->flags & MF_NOBLOCKMAP) || thing->blockcell < 0)
+        return;
+
+    block = &blockthings[thing->blockcell];
+
+    for (i = block->numthings - 1; i >= 0; i--)
+        if (block->things[i].mobj == thing)
+        {
+            block->things[i].x = thing->x;
+            block->things[i].y = thing->y;
+            block->things[i].radius = P_BlockThingRadius(thing);
+            break;
+        }
+}
+
+//
+// P_FreeBlockThings
+// Remove every thing from the blockmap.
+//
+void P_FreeBlockThings(void)
+{
+    int i;
+
+    if (!blockthings)
+        return;
+
+    for (i = 0; i < bmapwidth * bmapheight; i++)
+    {
+        free(blockthings[i].things);
+        blockthings[i].things = NULL;
+        blockthings[i].numthings = 0;
+        blockthings[i].maxthings = 0;
+    }
+}
+
 //
 // P_UnsetThingPosition
 // Unlinks a thing from block map and sectors.
@@ -230,35 +331,114 @@ void P_UnsetThingPosition(mobj_t *thing)
     {
         // inert things don't need to be in blockmap
         //
-        // killough 8/11/98: simpler scheme using pointers-to-pointers for prev
-        // pointers, allows head node pointers to be treated like everything else
-        //
-        // Also more robust, since it doesn't depend on current position for
-        // unlinking. Old method required computing head node based on position
-        // at time of unlinking, assuming it was the same position as during
-        // linking.
-        mobj_t  *bnext;
-        mobj_t  **bprev = thing->bprev;
-
-        if (bprev && (*bprev = bnext = thing->bnext))   // unlink from block map
-            bnext->bprev = bprev;
+        // [BH] doesn't depend on current position for unlinking, since the thing
+        //  may have been moved since it was linked
+        P_UnlinkBlockThing(thing);
+        blocklinksversion++;
     }
 }
 
 //
-// P_UnsetBloodSplatPosition
+// [BH] Blood splats are kept in a circular buffer in each sector, oldest first, so they
+//  can be projected one after the other, and the sectors they were added to are kept
+//  in a ring in the order they were spawned. The oldest splat in the map is always the
+//  oldest in the sector at the head of the ring, so once r_bloodsplats_max is reached
+//  it can be removed to make room without moving any other splats.
 //
-void P_UnsetBloodSplatPosition(bloodsplat_t *splat)
-{
-    bloodsplat_t        **sprev = splat->sprev;
-    bloodsplat_t        *snext = splat->snext;
+static int              *bloodsplatring;
+static int              bloodsplatringsize;
+static int              bloodsplatringhead;
 
-    if ((*sprev = snext))
-        snext->sprev = sprev;
+//
+// P_RemoveOldestBloodSplat
+//
+static void P_RemoveOldestBloodSplat(void)
+{
+    sector_t    *sector = &sectors[bloodsplatring[bloodsplatringhead]];
 
+    sector->firstsplat = (sector->firstsplat + 1) % sector->maxsplats;
+    sector->numsplats--;
+    bloodsplatringhead = (bloodsplatringhead + 1) % bloodsplatringsize;
     r_bloodsplats_total--;
+}
+
+//
+// P_RemoveBloodSplats
+// Remove every blood splat in sector, and close the gaps they leave in the ring so
+//  the rest are still removed oldest first.
+//
+void P_RemoveBloodSplats(sector_t *sector)
+{
+    int secnum = (int)(sector - sectors);
+    int count = 0;
+    int i;
+
+    if (!sector->numsplats)
+        return;
+
+    for (i = 0; i < r_bloodsplats_total; i++)
+    {
+        int s = bloodsplatring[(bloodsplatringhead + i) % bloodsplatringsize];
+
+        if (s != secnum)
+            bloodsplatring[(bloodsplatringhead + count++) % bloodsplatringsize] = s;
+    }
+
+    sector->firstsplat = 0;
+    sector->numsplats = 0;
+    r_bloodsplats_total = count;
+}
+
+//
+// P_ResizeBloodSplatRing
+// Called when r_bloodsplats_max has changed. The oldest splats are removed until
+//  there are no more than that, and the rest are kept in the order they were spawned.
+//
+void P_ResizeBloodSplatRing(void)
+{
+    int *ring = NULL;
+    int i;
 
-    free(splat);
+    if (bloodsplatringsize == r_bloodsplats_max)
+        return;
+
+    while (r_bloodsplats_total > r_bloodsplats_max)
+        P_RemoveOldestBloodSplat();
+
+    if (r_bloodsplats_max && !(ring = malloc(r_bloodsplats_max * sizeof(*ring))))
+        I_Error("P_ResizeBloodSplatRing: Failure trying to allocate %lu bytes",
+            (unsigned long)(r_bloodsplats_max * sizeof(*ring)));
+
+    for (i = 0; i < r_bloodsplats_total; i++)
+        ring[i] = bloodsplatring[(bloodsplatringhead + i) % bloodsplatringsize];
+
+    free(bloodsplatring);
+    bloodsplatring = ring;
+    bloodsplatringsize = r_bloodsplats_max;
+    bloodsplatringhead = 0;
+}
+
+//
+// P_FreeBloodSplats
+// Remove every blood splat in the map.
+//
+void P_FreeBloodSplats(void)
+{
+    int i;
+
+    for (i = 0; i < numsectors; i++)
+    {
+        if (sectors[i].splats)
+            Z_Free(sectors[i].splats);
+
+        sectors[i].splats = NULL;
+        sectors[i].firstsplat = 0;
+        sectors[i].numsplats = 0;
+        sectors[i].maxsplats = 0;
+    }
+
+    bloodsplatringhead = 0;
+    r_bloodsplats_total = 0;
 }
 
 //
@@ -272,6 +452,12 @@ void P_SetThingPosition(mobj_t *thing)
     // link into subsector
     subsector_t *ss = thing->subsector = R_PointInSubsector(thing->x, thing->y);
 
+    // [BH] wake thing if it has been moved, and any monsters that can now see the player
+    P_WakeMobj(thing);
+
+    if (thing->player)
+        P_WakeLookingMobjs();
+
     if (!(thing->flags & MF_NOSECTOR))
     {
         // invisible things don't go into the sector links
@@ -312,37 +498,50 @@ void P_SetThingPosition(mobj_t *thing)
 
         if (blockx >= 0 && blockx < bmapwidth && blocky >= 0 && blocky < bmapheight)
         {
-            // killough 8/11/98: simpler scheme using pointer-to-pointer prev
-            // pointers, allows head nodes to be treated like everything else
-            mobj_t      **link = &blocklinks[blocky * bmapwidth + blockx];
-            mobj_t      *bnext = *link;
-
-            if ((thing->bnext = bnext))
-                bnext->bprev = &thing->bnext;
-            thing->bprev = link;
-            *link = thing;
+            P_LinkBlockThing(thing, blocky * bmapwidth + blockx);
+            blocklinksversion++;
         }
         else
-        {
-            // thing is off the map
-            thing->bnext = NULL;
-            thing->bprev = NULL;
-        }
+            thing->blockcell = -1;      // thing is off the map
     }
 }
 
 //
 // P_SetBloodSplatPosition
+// Add a copy of splat to sector, removing the oldest splat in the map if there are
+//  already r_bloodsplats_max of them.
 //
-void P_SetBloodSplatPosition(bloodsplat_t *splat)
+void P_SetBloodSplatPosition(const bloodsplat_t *splat, sector_t *sector)
 {
-    bloodsplat_t        **link = &splat->sector->splatlist;
-    bloodsplat_t        *snext = *link;
+    P_ResizeBloodSplatRing();
+
+    if (!bloodsplatringsize)
+        return;
 
-    if ((splat->snext = snext))
-        snext->sprev = &splat->snext;
-    splat->sprev = link;
-    *link = splat;
+    if (r_bloodsplats_total == bloodsplatringsize)
+        P_RemoveOldestBloodSplat();
+
+    if (sector->numsplats == sector->maxsplats)
+    {
+        int             maxsplats = (sector->maxsplats ? sector->maxsplats * 2 : 16);
+        bloodsplat_t    *splats = Z_Malloc(maxsplats * sizeof(*splats), PU_LEVEL, NULL);
+        int             i;
+
+        // unwrap the splats already in the sector, oldest first
+        for (i = 0; i < sector->numsplats; i++)
+            splats[i] = sector->splats[(sector->firstsplat + i) % sector->maxsplats];
+
+        if (sector->splats)
+            Z_Free(sector->splats);
+
+        sector->splats = splats;
+        sector->firstsplat = 0;
+        sector->maxsplats = maxsplats;
+    }
+
+    sector->splats[(sector->firstsplat + sector->numsplats++) % sector->maxsplats] = *splat;
+    bloodsplatring[(bloodsplatringhead + r_bloodsplats_total++) % bloodsplatringsize] =
+        (int)(sector - sectors);
 }
 
 //
@@ -390,17 +589,251 @@ dboolean P_BlockLinesIterator(int x, int y, dboolean func(line_t *))
 
 //
 // P_BlockThingsIterator
+// [BH] The things in a block are visited newest first, as they were when each block
+//  had a linked list. If things are linked into or out of the block by func, iteration
+//  carries on as it would have along the list: things that are added aren't visited,
+//  and things that are removed before they are reached are skipped.
 //
-dboolean P_BlockThingsIterator(int x, int y, dboolean func(mobj_t *))
+static int P_ResumeBlockThings(const blockthings_t *block, int i, const mobj_t *mobj,
+    const mobj_t *next)
+{
+    int j;
+
+    // things can only have moved down in the array
+    for (j = MIN(i, block->numthings - 1); j >= 0; j--)
+        if (block->things[j].mobj == mobj)
+            return j;
+
+    // the thing that was visited has been removed, so carry on from the one after it
+    if (next)
+        for (j = MIN(i - 1, block->numthings - 1); j >= 0; j--)
+            if (block->things[j].mobj == next)
+                return j + 1;
+
+    return MIN(i, block->numthings);
+}
+
+static dboolean P_IterateBlockThings(int x, int y, const fixed_t *box, dboolean func(mobj_t *))
 {
     if (!(x < 0 || y < 0 || x >= bmapwidth || y >= bmapheight))
     {
-        mobj_t  *mobj;
+        blockthings_t   *block = &blockthings[y * bmapwidth + x];
+        int             i = block->numthings;
+
+        while (--i >= 0)
+        {
+            const blockthing_t  *blockthing = &block->things[i];
+            mobj_t              *mobj;
+            mobj_t              *next;
+            unsigned int        version;
+
+            if (box && (blockthing->x + blockthing->radius <= box[BOXLEFT]
+                || blockthing->x - blockthing->radius >= box[BOXRIGHT]
+                || blockthing->y + blockthing->radius <= box[BOXBOTTOM]
+                || blockthing->y - blockthing->radius >= box[BOXTOP]))
+                continue;
+
+            mobj = blockthing->mobj;
+            next = (i ? block->things[i - 1].mobj : NULL);
+            version = blocklinksversion;
 
-        for (mobj = blocklinks[y * bmapwidth + x]; mobj; mobj = mobj->bnext)
             if (!func(mobj))
                 return false;
+
+            if (blocklinksversion != version)
+                i = P_ResumeBlockThings(block, i, mobj, next);
+        }
     }
+
+    return true;
+}
+
+dboolean P_BlockThingsIterator(int x, int y, dboolean func(mobj_t *))
+{
+    return P_IterateBlockThings(x, y, NULL, func);
+}
+
+//
+// P_BlockThingsBoxIterator
+// [BH] The same as P_BlockThingsIterator(), but only calls func for things that could
+//  overlap box. func must still check for itself, and do nothing to a thing before then.
+//
+dboolean P_BlockThingsBoxIterator(int x, int y, const fixed_t *box, dboolean func(mobj_t *))
+{
+    return P_IterateBlockThings(x, y, box, func);
+}
+
+//
+// [BH] HITSCAN BATCHES
+// The pellets of a shotgun blast, or the aim and shot of a hitscan monster, are all
+//  traced from the same point within a narrow fan. The first time a trace in a batch
+//  passes through a blockmap cell, the things in it are tested once against the whole
+//  fan, and only those that any trace in the fan could hit are kept for the rest of the
+//  batch. If a thing is linked into or out of the blockmap in the meantime, or a trace
+//  isn't from the source or within the fan, the blockmap is used instead, so every
+//  trace still finds exactly what it would have otherwise, in the same order.
+//
+typedef struct
+{
+    unsigned int        batch;
+    int                 first;
+    int                 count;
+} batchcell_t;
+
+static mobj_t           **batchthings;
+static int              numbatchthings;
+static int              maxbatchthings;
+static batchcell_t      *batchcells;
+static int              maxbatchcells;
+static int              batchx, batchy;
+static int              batchwidth, batchheight;
+static fixed_t          batchsourcex, batchsourcey;
+static fixed_t          batchleft[2], batchright[2];
+static unsigned int     batchversion;
+static unsigned int     batchnum;
+static dboolean         batching;
+static dboolean         batchtrace;
+
+//
+// P_InHitscanFan
+// Returns true if the point (x, y) is inside the fan of the current batch, or no more
+//  than pad outside it.
+//
+static dboolean P_InHitscanFan(fixed_t x, fixed_t y, fixed_t pad)
+{
+    int64_t dx = (int64_t)x - batchsourcex;
+    int64_t dy = (int64_t)y - batchsourcey;
+
+    return (batchleft[0] * dy - batchleft[1] * dx <= (int64_t)pad * FRACUNIT
+        && batchright[0] * dy - batchright[1] * dx >= -(int64_t)pad * FRACUNIT);
+}
+
+//
+// P_StartHitscanBatch
+// Start a batch of traces from source, up to MISSILERANGE away and within spread of
+//  the direction it's facing.
+//
+void P_StartHitscanBatch(mobj_t *source, angle_t spread)
+{
+    fixed_t     bbox[4];
+    angle_t     angle = source->angle;
+    angle_t     angles[] = { angle - spread, angle, angle + spread, 0, ANG90, ANG180, ANG270 };
+    int         x1, y1, x2, y2;
+    int         i;
+
+    if (spread >= ANG90 - ANG5 || !blockthings)
+        return;
+
+    M_ClearBox(bbox);
+    M_AddToBox(bbox, source->x, source->y);
+
+    // include the ends of the fan, and its furthest point in each direction
+    for (i = 0; i < arrlen(angles); i++)
+        if (i < 3 || angles[i] - angles[0] <= 2 * spread)
+        {
+            int an = angles[i] >> ANGLETOFINESHIFT;
+
+            M_AddToBox(bbox, source->x + (MISSILERANGE >> FRACBITS) * finecosine[an],
+                source->y + (MISSILERANGE >> FRACBITS) * finesine[an]);
+        }
+
+    x1 = MAX(0, ((bbox[BOXLEFT] - bmaporgx) >> MAPBLOCKSHIFT) - 1);
+    y1 = MAX(0, ((bbox[BOXBOTTOM] - bmaporgy) >> MAPBLOCKSHIFT) - 1);
+    x2 = MIN(bmapwidth - 1, ((bbox[BOXRIGHT] - bmaporgx) >> MAPBLOCKSHIFT) + 1);
+    y2 = MIN(bmapheight - 1, ((bbox[BOXTOP] - bmaporgy) >> MAPBLOCKSHIFT) + 1);
+
+    if (x1 > x2 || y1 > y2)
+        return;
+
+    batchx = x1;
+    batchy = y1;
+    batchwidth = x2 - x1 + 1;
+    batchheight = y2 - y1 + 1;
+
+    if (batchwidth * batchheight > maxbatchcells)
+    {
+        batchcells = Z_Realloc(batchcells, batchwidth * batchheight * sizeof(*batchcells));
+        memset(batchcells + maxbatchcells, 0,
+            (batchwidth * batchheight - maxbatchcells) * sizeof(*batchcells));
+        maxbatchcells = batchwidth * batchheight;
+    }
+
+    // cells gathered in an earlier batch are gathered again
+    if (!++batchnum)
+    {
+        memset(batchcells, 0, maxbatchcells * sizeof(*batchcells));
+        batchnum = 1;
+    }
+
+    // the edges of the fan, widened a little so traces at either end are still inside it
+    spread += 2 << ANGLETOFINESHIFT;
+    batchleft[0] = finecosine[(angle + spread) >> ANGLETOFINESHIFT];
+    batchleft[1] = finesine[(angle + spread) >> ANGLETOFINESHIFT];
+    batchright[0] = finecosine[(angle - spread) >> ANGLETOFINESHIFT];
+    batchright[1] = finesine[(angle - spread) >> ANGLETOFINESHIFT];
+    batchsourcex = source->x;
+    batchsourcey = source->y;
+
+    numbatchthings = 0;
+    batchversion = blocklinksversion;
+    batching = true;
+}
+
+//
+// P_EndHitscanBatch
+//
+void P_EndHitscanBatch(void)
+{
+    batching = false;
+}
+
+//
+// P_BatchThingsIterator
+// The same as P_BlockThingsIterator(), but only testing the things in the cell that
+//  are near enough the fan of the current batch if the trace is part of it.
+//
+static dboolean P_BatchThingsIterator(int x, int y, dboolean func(mobj_t *))
+{
+    batchcell_t *cell;
+    int         i;
+
+    if (!batchtrace || batchversion != blocklinksversion || x < batchx || x >= batchx + batchwidth
+        || y < batchy || y >= batchy + batchheight)
+        return P_BlockThingsIterator(x, y, func);
+
+    cell = &batchcells[(y - batchy) * batchwidth + x - batchx];
+
+    if (cell->batch != batchnum)
+    {
+        blockthings_t   *block = &blockthings[y * bmapwidth + x];
+
+        if (numbatchthings + block->numthings > maxbatchthings)
+        {
+            maxbatchthings = MAX(maxbatchthings * 2, numbatchthings + block->numthings + 256);
+            batchthings = Z_Realloc(batchthings, maxbatchthings * sizeof(*batchthings));
+        }
+
+        cell->batch = batchnum;
+        cell->first = numbatchthings;
+
+        // PIT_AddThingIntercepts() tests a diagonal of the thing, which is within
+        //  radius * sqrt(2) of it, and P_PointOnDivlineSide() and nudging the start
+        //  of a trace off a block edge both round by a few units
+        for (i = block->numthings - 1; i >= 0; i--)
+        {
+            blockthing_t    *thing = &block->things[i];
+
+            if (P_InHitscanFan(thing->x, thing->y, 2 * thing->radius + 8 * FRACUNIT))
+                batchthings[numbatchthings++] = thing->mobj;
+        }
+
+        cell->count = numbatchthings - cell->first;
+    }
+
+    for (i = cell->first; i < cell->first + cell->count; i++)
+        if (!func(batchthings[i]))
+            return false;
+
     return true;
 }
 
@@ -428,6 +861,9 @@ static void check_intercept(void)
 
 divline_t       dlTrace;
 
+// [BH] counted for -simulate
+int             pathtraversecalls;
+
 //
 // PIT_AddLineIntercepts.
 // Looks for lines in the given block
@@ -588,9 +1024,14 @@ dboolean P_PathTraverse(fixed_t x1, fixed_t y1, fixed_t x2, fixed_t y2, int flag
     int         mapxstep, mapystep;
     int         count;
 
+    pathtraversecalls++;
+
     validcount++;
     intercept_p = intercepts;
 
+    // [BH] only use the current hitscan batch if this trace is part of it
+    batchtrace = (batching && x1 == batchsourcex && y1 == batchsourcey && P_InHitscanFan(x2, y2, 0));
+
     if (!((x1 - bmaporgx) & (MAPBLOCKSIZE - 1)))
         x1 += FRACUNIT;         // don't side exactly on a line
 
@@ -670,7 +1111,7 @@ dboolean P_PathTraverse(fixed_t x1, fixed_t y1, fixed_t x2, fixed_t y2, int flag
                 return false;           // early out
 
         if (flags & PT_ADDTHINGS)
-            if (!P_BlockThingsIterator(mapx, mapy, PIT_AddThingIntercepts))
+            if (!P_BatchThingsIterator(mapx, mapy, PIT_AddThingIntercepts))
                 return false;           // early out
 
         if (mapx == xt2 && mapy == yt2)
@@ -48,6 +48,7 @@
 #include "st_stuff.h"
 #include "z_zone.h"
 
+void A_Look(mobj_t *actor, player_t *player, pspdef_t *psp);
 void G_PlayerReborn(void);
 void P_DelSeclist(msecnode_t *node);
 
@@ -107,6 +108,8 @@ dboolean P_SetMobjState(mobj_t *mobj, statenum_t state)
     state_t     *st;
     int         cycle_counter = 0;
 
+    P_WakeMobj(mobj);
+
     do
     {
         if (state == S_NULL)
@@ -546,6 +549,181 @@ void P_NightmareRespawn(mobj_t *mobj)
     P_RemoveMobj(mobj);
 }
 
+//
+// [BH] SLEEPING MOBJS
+// When sleepthinkers is on, a mobj that P_MobjThinker() wouldn't change is put to sleep and
+//  skipped by P_RunThinkers() until something happens to it. That is either a mobj with a
+//  state that never ends, or a monster looking for the player that the REJECT table
+//  already knows it can't see, and that the player can't see either, so its animation
+//  doesn't appear to freeze. A monster that is woken has its states advanced by however
+//  many tics it slept through.
+//
+#define MAXLOOKSTATES   8
+
+//
+// P_IsRejected
+// Returns true if the REJECT table says that neither sector can be seen from the other.
+//
+static dboolean P_IsRejected(sector_t *sector1, sector_t *sector2)
+{
+    int s1 = (int)(sector1 - sectors);
+    int s2 = (int)(sector2 - sectors);
+    int pnum1 = s1 * numsectors + s2;
+    int pnum2 = s2 * numsectors + s1;
+
+    return ((rejectmatrix[pnum1 >> 3] & (1 << (pnum1 & 7)))
+        && (rejectmatrix[pnum2 >> 3] & (1 << (pnum2 & 7))));
+}
+
+//
+// P_IsLookingCycle
+// Returns true if the states from mobj's current state only look for the player, and
+//  lead back to it.
+//
+static dboolean P_IsLookingCycle(mobj_t *mobj)
+{
+    state_t *st = mobj->state;
+    int     i;
+
+    for (i = 0; i < MAXLOOKSTATES; i++)
+    {
+        if (st->tics <= 0 || (st->action && st->action != (actionf_t)A_Look) || st->nextstate == S_NULL)
+            return false;
+
+        if ((st = &states[st->nextstate]) == mobj->state)
+            return true;
+    }
+
+    return false;
+}
+
+//
+// P_CanMobjSleep
+// Returns true if P_MobjThinker() would leave mobj as it is on each of the tics that follow,
+//  until something else changes it.
+//
+static dboolean P_CanMobjSleep(mobj_t *mobj)
+{
+    int         flags = mobj->flags;
+    int         flags2 = mobj->flags2;
+    sector_t    *sector = mobj->subsector->sector;
+    mobj_t      *mo = players[0].mo;
+
+    if (mobj->thinker.function != P_MobjThinker || mobj->player || mobj->type == MT_MUSICSOURCE)
+        return false;
+
+    if ((mobj->momx | mobj->momy | mobj->momz) || (flags & MF_SKULLFLY) || mobj->nudge
+        || mobj->z != mobj->floorz || (flags2 & (MF2_FEETARECLIPPED | MF2_FLOATBOB)))
+        return false;
+
+    // don't interpolate from a position mobj was in before it slept
+    if (!mobj->interp || mobj->x != mobj->oldx || mobj->y != mobj->oldy || mobj->z != mobj->oldz
+        || mobj->angle != mobj->oldangle)
+        return false;
+
+    if (!sentient(mobj) && ((flags2 & MF2_FALLING) || mobj->gear || (!(flags & MF_NOGRAVITY)
+        && ((mobj->health <= 0 && mobj->z - mobj->dropoffz > 2 * FRACUNIT)
+            || ((flags & MF_COUNTKILL) && mobj->z - mobj->dropoffz > 24 * FRACUNIT)))))
+        return false;
+
+    if (mobj->tics == -1)
+        return !((flags & MF_COUNTKILL) && (gameskill == sk_nightmare || respawnmonsters));
+
+    // A_Look() fails if there's no sound to wake the monster, and it can't see the player
+    if (infight || sector->soundtarget || mobj->lastenemy || mobj->threshold || !mo
+        || !P_IsRejected(sector, mo->subsector->sector))
+        return false;
+
+    return P_IsLookingCycle(mobj);
+}
+
+//
+// P_CatchUpMobj
+// Advances the states of a sleeping mobj to the last tic it would have had its turn in.
+//
+void P_CatchUpMobj(mobj_t *mobj)
+{
+    int     lasttic = P_LastThinkerTic(&mobj->thinker);
+    int     tics = lasttic - mobj->sleeptic;
+    int     period = 0;
+    state_t *st = mobj->state;
+
+    mobj->sleeptic = lasttic;
+
+    if (tics <= 0 || mobj->tics == -1)
+        return;
+
+    do
+    {
+        period += st->tics;
+        st = &states[st->nextstate];
+    } while (st != mobj->state);
+
+    while (tics >= mobj->tics)
+    {
+        tics -= mobj->tics;
+        st = &states[mobj->state->nextstate];
+        mobj->state = st;
+        mobj->tics = st->tics;
+        mobj->sprite = st->sprite;
+        mobj->frame = st->frame;
+        tics %= period;
+    }
+
+    mobj->tics -= tics;
+}
+
+//
+// P_WakeMobj
+//
+void P_WakeMobj(mobj_t *mobj)
+{
+    if (mobj->thinker.sleeping)
+    {
+        P_CatchUpMobj(mobj);
+        mobj->thinker.sleeping = false;
+        sleepingthinkers--;
+    }
+}
+
+//
+// P_WakeMobjs
+// Wakes every sleeping mobj, when something that they all depend on changes.
+//
+void P_WakeMobjs(void)
+{
+    thinker_t   *th;
+
+    for (th = thinkerclasscap[th_mobj].cnext; th != &thinkerclasscap[th_mobj] && sleepingthinkers;
+        th = th->cnext)
+        P_WakeMobj((mobj_t *)th);
+}
+
+//
+// P_WakeLookingMobjs
+// Wakes the sleeping monsters that may now see, or be seen by, the player.
+//
+void P_WakeLookingMobjs(void)
+{
+    static sector_t *playersector;
+    mobj_t          *mo = players[0].mo;
+    thinker_t       *th;
+
+    if (!mo || mo->subsector->sector == playersector)
+        return;
+
+    playersector = mo->subsector->sector;
+
+    for (th = thinkerclasscap[th_mobj].cnext; th != &thinkerclasscap[th_mobj] && sleepingthinkers;
+        th = th->cnext)
+    {
+        mobj_t  *mobj = (mobj_t *)th;
+
+        if (th->sleeping && mobj->tics != -1 && !P_IsRejected(mobj->subsector->sector, playersector))
+            P_WakeMobj(mobj);
+    }
+}
+
 static void PlayerLandedOnThing(mobj_t *mo)
 {
     mo->player->deltaviewheight = mo->momz >> 3;
@@ -689,6 +867,13 @@ void P_MobjThinker(mobj_t *mobj)
                 P_NightmareRespawn(mobj);
         }
     }
+
+    if (sleepthinkers && P_CanMobjSleep(mobj))
+    {
+        mobj->thinker.sleeping = true;
+        mobj->sleeptic = leveltime;
+        sleepingthinkers++;
+    }
 }
 
 //
@@ -696,7 +881,7 @@ void P_MobjThinker(mobj_t *mobj)
 //
 mobj_t *P_SpawnMobj(fixed_t x, fixed_t y, fixed_t z, mobjtype_t type)
 {
-    mobj_t      *mobj = Z_Calloc(1, sizeof(*mobj), PU_LEVEL, NULL);
+    mobj_t      *mobj = Z_PoolCalloc(&mobjpool, PU_LEVEL, NULL);
     state_t     *st;
     mobjinfo_t  *info = &mobjinfo[type];
     sector_t    *sector;
@@ -797,6 +982,8 @@ void P_RemoveMobj(mobj_t *mobj)
     int         flags = mobj->flags;
     mobjtype_t  type = mobj->type;
 
+    P_WakeMobj(mobj);
+
     if (respawnitems && (flags & MF_SPECIAL) && !(flags & MF_DROPPED) && type != MT_INV
         && type != MT_INS)
     {
@@ -1208,7 +1395,7 @@ void P_SpawnBlood(fixed_t x, fixed_t y, fixed_t z, angle_t angle, int damage, mo
 
     for (i = (damage >> 2) + 1; i; i--)
     {
-        mobj_t      *th = Z_Calloc(1, sizeof(*th), PU_LEVEL, NULL);
+        mobj_t      *th = Z_PoolCalloc(&mobjpool, PU_LEVEL, NULL);
         state_t     *st = &states[info->spawnstate];
 
         th->type = color;
@@ -1258,7 +1445,7 @@ extern short    firstbloodsplatlump;
 
 void P_SpawnBloodSplat(fixed_t x, fixed_t y, int blood, int maxheight, mobj_t *target)
 {
-    if (r_bloodsplats_total == r_bloodsplats_max)
+    if (!r_bloodsplats_max)
         return;
     else
     {
@@ -1266,26 +1453,23 @@ void P_SpawnBloodSplat(fixed_t x, fixed_t y, int blood, int maxheight, mobj_t *t
 
         if (!sec->isliquid && sec->interpfloorheight <= maxheight && sec->floorpic != skyflatnum)
         {
-            bloodsplat_t    *splat = malloc(sizeof(*splat));
+            bloodsplat_t    splat;
 
-            splat->frame = firstbloodsplatlump + (rand() & 7);
-            splat->flags = rand() & BSF_MIRRORED;
+            splat.frame = firstbloodsplatlump + (rand() & 7);
+            splat.flags = rand() & BSF_MIRRORED;
 
             if (blood == FUZZYBLOOD)
             {
-                splat->flags |= BSF_FUZZ;
-                splat->colfunc = fuzzcolfunc;
+                splat.flags |= BSF_FUZZ;
+                splat.colfunc = fuzzcolfunc;
             }
             else
-                splat->colfunc = bloodsplatcolfunc;
-
-            splat->blood = blood;
-            splat->x = x;
-            splat->y = y;
-            splat->sector = sec;
-            P_SetBloodSplatPosition(splat);
+                splat.colfunc = bloodsplatcolfunc;
 
-            r_bloodsplats_total++;
+            splat.blood = blood;
+            splat.x = x;
+            splat.y = y;
+            P_SetBloodSplatPosition(&splat, sec);
 
             if (target && target->bloodsplats)
                 target->bloodsplats--;
@@ -1307,6 +1491,7 @@ void P_CheckMissileSpawn(mobj_t *th)
     th->x += (th->momx >> 1);
     th->y += (th->momy >> 1);
     th->z += (th->momz >> 1);
+    P_UpdateBlockThing(th);
 
     if (!P_TryMove(th, th->x, th->y, false))
         P_ExplodeMissile(th);
@@ -331,9 +331,8 @@ typedef struct mobj_s
     int                 frame;          // might be ORed with FF_FULLBRIGHT
 
     // Interaction info, by BLOCKMAP.
-    // Links in blocks (if needed).
-    struct mobj_s       *bnext;
-    struct mobj_s       **bprev;        // killough 8/11/98: change to ptr-to-ptr
+    // [BH] Block the thing is in (if needed), or -1.
+    int                 blockcell;
 
     struct subsector_s  *subsector;
 
@@ -421,6 +420,9 @@ typedef struct mobj_s
 
     fixed_t             nudge;
 
+    // [BH] last tic mobj has been brought up to date to while sleeping
+    int                 sleeptic;
+
     int                 pitch;
 
     int                 id;
@@ -430,10 +432,7 @@ typedef struct bloodsplat_s
 {
     fixed_t             x;
     fixed_t             y;
-    struct bloodsplat_s *snext;
-    struct bloodsplat_s **sprev;
     int                 frame;
-    struct sector_s     *sector;
     int                 flags;
     int                 blood;
 
@@ -187,7 +187,7 @@ dboolean EV_DoPlat(line_t *line, plattype_e type, int amount)
 
         // Find lowest & highest floors around sector
         rtn = true;
-        plat = Z_Calloc(1, sizeof(*plat), PU_LEVSPEC, NULL);
+        plat = Z_PoolCalloc(&platpool, PU_LEVSPEC, NULL);
         P_AddThinker(&plat->thinker);
 
         plat->type = type;
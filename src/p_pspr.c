@@ -636,11 +636,13 @@ void A_FirePistol(mobj_t *actor, player_t *player, pspdef_t *psp)
 
     P_SetPsprite(player, ps_flash, weaponinfo[player->readyweapon].flashstate);
 
+    P_StartHitscanBatch(actor, 1 << 26);
     P_BulletSlope(actor);
 
     successfulshot = false;
 
     P_GunShot(actor, !player->refire);
+    P_EndHitscanBatch();
 
     if (successfulshot)
     {
@@ -669,6 +671,7 @@ void A_FireShotgun(mobj_t *actor, player_t *player, pspdef_t *psp)
 
     P_SetPsprite(player, ps_flash, weaponinfo[player->readyweapon].flashstate);
 
+    P_StartHitscanBatch(actor, 1 << 26);
     P_BulletSlope(actor);
 
     successfulshot = false;
@@ -676,6 +679,8 @@ void A_FireShotgun(mobj_t *actor, player_t *player, pspdef_t *psp)
     for (i = 0; i < 7; i++)
         P_GunShot(actor, false);
 
+    P_EndHitscanBatch();
+
     if (successfulshot)
     {
         successfulshot = false;
@@ -705,6 +710,7 @@ void A_FireShotgun2(mobj_t *actor, player_t *player, pspdef_t *psp)
 
     P_SetPsprite(player, ps_flash, weaponinfo[player->readyweapon].flashstate);
 
+    P_StartHitscanBatch(actor, 255 << ANGLETOFINESHIFT);
     P_BulletSlope(actor);
 
     successfulshot = false;
@@ -718,6 +724,8 @@ void A_FireShotgun2(mobj_t *actor, player_t *player, pspdef_t *psp)
             damage);
     }
 
+    P_EndHitscanBatch();
+
     if (successfulshot)
     {
         successfulshot = false;
@@ -767,11 +775,13 @@ void A_FireCGun(mobj_t *actor, player_t *player, pspdef_t *psp)
     P_SetPsprite(player, ps_flash, weaponinfo[player->readyweapon].flashstate
         + (unsigned int)((psp->state - &states[S_CHAIN1]) & 1));
 
+    P_StartHitscanBatch(actor, 1 << 26);
     P_BulletSlope(actor);
 
     successfulshot = false;
 
     P_GunShot(actor, !player->refire);
+    P_EndHitscanBatch();
 
     if (successfulshot && psp->state == &states[S_CHAIN1])
     {
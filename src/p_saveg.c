@@ -49,12 +49,31 @@
 
 #define SAVEGAME_EOF    0x1D
 
-FILE    *save_stream;
 int     savegamelength;
 
+// [BH] The savegame being written or read. It's written into this buffer, and then
+//  saved to disk in one go, and read from it after being loaded in one go.
+static byte     *savebuffer;
+static size_t   savebuffersize;
+static size_t   savelength;
+static size_t   saveoffset;
+
 extern dboolean r_textures;
 extern dboolean r_translucency;
 
+// [BH] The buffer is allocated with realloc() and freed with free(), rather than in the
+//  zone, so the savegame thread can free it once it's been written.
+static void saveg_resize(size_t size)
+{
+    byte    *buffer = realloc(savebuffer, size);
+
+    if (!buffer)
+        I_Error("saveg_resize: Failure trying to allocate %lu bytes", (unsigned long)size);
+
+    savebuffer = buffer;
+    savebuffersize = size;
+}
+
 // Get the filename of a temporary file to write the savegame to. After
 // the file has been successfully saved, it will be renamed to the
 // real file.
@@ -87,19 +106,134 @@ char *P_SaveGameFile(int slot)
     return filename;
 }
 
-// Endian-safe integer read/write functions
-static byte saveg_read8(void)
+//
+// P_OpenSaveGame
+// [BH] Read a savegame into memory so it can be unarchived.
+//
+dboolean P_OpenSaveGame(char *filename)
+{
+    FILE    *file = fopen(filename, "rb");
+    long    length;
+
+    if (!file)
+        return false;
+
+    fseek(file, 0, SEEK_END);
+    length = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    if (length <= 0)
+    {
+        fclose(file);
+        return false;
+    }
+
+    if ((size_t)length > savebuffersize)
+        saveg_resize(length);
+
+    savelength = fread(savebuffer, 1, length, file);
+    saveoffset = 0;
+    fclose(file);
+
+    return (savelength == (size_t)length);
+}
+
+//
+// P_CreateSaveGame
+// [BH] Start writing a new savegame into memory.
+//
+void P_CreateSaveGame(void)
+{
+    savelength = 0;
+    saveoffset = 0;
+}
+
+//
+// P_TakeSaveGame
+// [BH] Returns the savegame that's been written into memory, and its length. The
+//  caller owns it, and must free it with P_FreeSaveGame(), and the next savegame is
+//  written into a new buffer.
+//
+byte *P_TakeSaveGame(size_t *length)
+{
+    byte    *result = savebuffer;
+
+    *length = saveoffset;
+    savebuffer = NULL;
+    savebuffersize = 0;
+    savelength = 0;
+    saveoffset = 0;
+
+    return result;
+}
+
+//
+// P_FreeSaveGame
+// [BH] Frees a savegame returned by P_TakeSaveGame(). Doesn't touch the zone, so can be
+//  called from any thread.
+//
+void P_FreeSaveGame(byte *buffer)
+{
+    free(buffer);
+}
+
+//
+// P_WriteSaveGame
+// [BH] Write a savegame in memory to a file in one go. Returns the number of bytes
+//  written, or 0 if they couldn't all be. Doesn't touch the state of the game, so can
+//  be called from any thread.
+//
+size_t P_WriteSaveGame(char *filename, byte *buffer, size_t length)
+{
+    FILE    *file = fopen(filename, "wb");
+    size_t  written;
+
+    if (!file)
+        return 0;
+
+    written = fwrite(buffer, 1, length, file);
+
+    if (fclose(file) || written != length)
+        return 0;
+
+    return written;
+}
+
+static byte *saveg_reserve(size_t size)
 {
-    byte        result = -1;
+    byte    *result;
 
-    fread(&result, 1, 1, save_stream);
+    if (saveoffset + size > savebuffersize)
+    {
+        size_t  newsize = MAX(65536, (int)savebuffersize * 2);
+
+        while (saveoffset + size > newsize)
+            newsize *= 2;
 
+        saveg_resize(newsize);
+    }
+
+    result = savebuffer + saveoffset;
+    saveoffset += size;
     return result;
 }
 
+// Endian-safe integer read/write functions
+static byte saveg_read8(void)
+{
+    // [BH] reading past the end of the savegame gives the same result as fread() did
+    if (saveoffset >= savelength)
+    {
+        saveoffset++;
+        return 0xFF;
+    }
+
+    return savebuffer[saveoffset++];
+}
+
 static void saveg_write8(byte value)
 {
-    fwrite(&value, 1, 1, save_stream);
+    *saveg_reserve(1) = value;
 }
 
 static short saveg_read16(void)
@@ -114,49 +248,56 @@ static short saveg_read16(void)
 
 static void saveg_write16(short value)
 {
-    saveg_write8(value & 0xFF);
-    saveg_write8((value >> 8) & 0xFF);
+    byte    *p = saveg_reserve(2);
+
+    p[0] = value & 0xFF;
+    p[1] = (value >> 8) & 0xFF;
 }
 
 static int saveg_read32(void)
 {
     int result;
 
-    result = saveg_read8();
-    result |= saveg_read8() << 8;
-    result |= saveg_read8() << 16;
-    result |= saveg_read8() << 24;
+    if (saveoffset + 4 > savelength)
+    {
+        result = saveg_read8();
+        result |= saveg_read8() << 8;
+        result |= saveg_read8() << 16;
+        result |= saveg_read8() << 24;
+    }
+    else
+    {
+        byte    *p = savebuffer + saveoffset;
+
+        result = p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned int)p[3] << 24);
+        saveoffset += 4;
+    }
 
     return result;
 }
 
 static void saveg_write32(int value)
 {
-    saveg_write8(value & 0xFF);
-    saveg_write8((value >> 8) & 0xFF);
-    saveg_write8((value >> 16) & 0xFF);
-    saveg_write8((value >> 24) & 0xFF);
+    byte    *p = saveg_reserve(4);
+
+    p[0] = value & 0xFF;
+    p[1] = (value >> 8) & 0xFF;
+    p[2] = (value >> 16) & 0xFF;
+    p[3] = (value >> 24) & 0xFF;
 }
 
 // Pad to 4-byte boundaries
 static void saveg_read_pad(void)
 {
-    unsigned long       pos = ftell(save_stream);
-    int                 padding = (4 - (pos & 3)) & 3;
-    int                 i;
-
-    for (i = 0; i < padding; i++)
-        saveg_read8();
+    saveoffset += (4 - (saveoffset & 3)) & 3;
 }
 
 static void saveg_write_pad(void)
 {
-    unsigned long       pos = ftell(save_stream);
-    int                 padding = (4 - (pos & 3)) & 3;
-    int                 i;
+    int padding = (4 - (saveoffset & 3)) & 3;
 
-    for (i = 0; i < padding; i++)
-        saveg_write8(0);
+    if (padding)
+        memset(saveg_reserve(padding), 0, padding);
 }
 
 // Pointers
@@ -214,8 +355,10 @@ static void saveg_read_mobj_t(mobj_t *str)
     str->angle = saveg_read32();
     str->sprite = (spritenum_t)saveg_read_enum();
     str->frame = saveg_read32();
-    str->bnext = (mobj_t *)saveg_readp();
-    str->bprev = (mobj_t **)saveg_readp();
+    // [BH] blockmap links are no longer saved, but their space is kept
+    saveg_readp();
+    saveg_readp();
+    str->blockcell = -1;
     str->subsector = (subsector_t *)saveg_readp();
     str->floorz = saveg_read32();
     str->ceilingz = saveg_read32();
@@ -274,8 +417,8 @@ static void saveg_write_mobj_t(mobj_t *str)
     saveg_write32(str->angle);
     saveg_write_enum(str->sprite);
     saveg_write32(str->frame);
-    saveg_writep(str->bnext);
-    saveg_writep(str->bprev);
+    saveg_writep(NULL);
+    saveg_writep(NULL);
     saveg_writep(str->subsector);
     saveg_write32(str->floorz);
     saveg_write32(str->ceilingz);
@@ -1053,6 +1196,9 @@ void P_UnArchiveWorld(void)
             si->midtexture = saveg_read16();
         }
     }
+
+    // [BH] line flags and sector heights have changed
+    P_BuildSoundGraph();
 }
 
 //
@@ -1067,6 +1213,9 @@ void P_ArchiveThinkers(void)
     thinker_t   *th;
     int         i;
 
+    // [BH] bring sleeping things up to date
+    P_WakeMobjs();
+
     // save off the current thinkers
     for (th = thinkerclasscap[th_mobj].cnext; th != &thinkerclasscap[th_mobj]; th = th->cnext)
     {
@@ -1078,13 +1227,15 @@ void P_ArchiveThinkers(void)
     // save off the bloodsplats
     for (i = 0; i < numsectors; i++)
     {
-        bloodsplat_t    *splat;
+        sector_t    *sector = &sectors[i];
+        int         j;
 
-        for (splat = sectors[i].splatlist; splat; splat = splat->snext)
+        // oldest first, so they're added back in the same order
+        for (j = 0; j < sector->numsplats; j++)
         {
             saveg_write8(tc_bloodsplat);
             saveg_write_pad();
-            saveg_write_bloodsplat_t(splat);
+            saveg_write_bloodsplat_t(&sector->splats[(sector->firstsplat + j) % sector->maxsplats]);
         }
     }
 
@@ -1112,7 +1263,6 @@ void P_UnArchiveThinkers(void)
 {
     thinker_t   *currentthinker = thinkercap.next;
     thinker_t   *next;
-    int i;
 
     // remove all the current thinkers
     while (currentthinker != &thinkercap)
@@ -1133,18 +1283,7 @@ void P_UnArchiveThinkers(void)
     P_InitThinkers();
 
     // remove the remaining bloodsplats
-    for (i = 0; i < numsectors; i++)
-    {
-        bloodsplat_t    *splat = sectors[i].splatlist;
-
-        while (splat)
-        {
-            bloodsplat_t    *next = splat->snext;
-
-            P_UnsetBloodSplatPosition(splat);
-            splat = next;
-        }
-    }
+    P_FreeBloodSplats();
 
     // read in saved thinkers
     while (1)
@@ -1158,13 +1297,13 @@ void P_UnArchiveThinkers(void)
 
             case tc_mobj:
             {
-                mobj_t  *mobj = Z_Malloc(sizeof(*mobj), PU_LEVEL, NULL);
+                mobj_t  *mobj = Z_PoolMalloc(&mobjpool, PU_LEVEL, NULL);
 
                 saveg_read_pad();
                 saveg_read_mobj_t(mobj);
 
-                P_SetThingPosition(mobj);
                 mobj->info = &mobjinfo[mobj->type];
+                P_SetThingPosition(mobj);
 
                 mobj->thinker.function = P_MobjThinker;
                 mobj->colfunc = mobj->info->colfunc;
@@ -1181,18 +1320,13 @@ void P_UnArchiveThinkers(void)
 
             case tc_bloodsplat:
             {
-                bloodsplat_t    *splat = Z_Malloc(sizeof(*splat), PU_LEVEL, NULL);
+                bloodsplat_t    splat;
 
                 saveg_read_pad();
-                saveg_read_bloodsplat_t(splat);
+                saveg_read_bloodsplat_t(&splat);
 
-                if (r_bloodsplats_total < r_bloodsplats_max)
-                {
-                    splat->sector = R_PointInSubsector(splat->x, splat->y)->sector;
-                    P_SetBloodSplatPosition(splat);
-                    splat->colfunc = (splat->blood == FUZZYBLOOD ? fuzzcolfunc : bloodsplatcolfunc);
-                    r_bloodsplats_total++;
-                }
+                splat.colfunc = (splat.blood == FUZZYBLOOD ? fuzzcolfunc : bloodsplatcolfunc);
+                P_SetBloodSplatPosition(&splat, R_PointInSubsector(splat.x, splat.y)->sector);
                 break;
             }
 
@@ -1432,7 +1566,7 @@ void P_UnArchiveSpecials(void)
 
             case tc_ceiling:
                 saveg_read_pad();
-                ceiling = Z_Malloc(sizeof(*ceiling), PU_LEVEL, NULL);
+                ceiling = Z_PoolMalloc(&ceilingpool, PU_LEVEL, NULL);
                 saveg_read_ceiling_t(ceiling);
                 ceiling->sector->ceilingdata = ceiling;
                 ceiling->thinker.function = T_MoveCeiling;
@@ -1442,7 +1576,7 @@ void P_UnArchiveSpecials(void)
 
             case tc_door:
                 saveg_read_pad();
-                door = Z_Malloc(sizeof(*door), PU_LEVEL, NULL);
+                door = Z_PoolMalloc(&doorpool, PU_LEVEL, NULL);
                 saveg_read_vldoor_t(door);
                 door->sector->ceilingdata = door;
                 door->thinker.function = T_VerticalDoor;
@@ -1451,7 +1585,7 @@ void P_UnArchiveSpecials(void)
 
             case tc_floor:
                 saveg_read_pad();
-                floor = Z_Malloc(sizeof(*floor), PU_LEVEL, NULL);
+                floor = Z_PoolMalloc(&floorpool, PU_LEVEL, NULL);
                 saveg_read_floormove_t(floor);
                 floor->sector->floordata = floor;
                 floor->thinker.function = T_MoveFloor;
@@ -1460,7 +1594,7 @@ void P_UnArchiveSpecials(void)
 
             case tc_plat:
                 saveg_read_pad();
-                plat = Z_Malloc(sizeof(*plat), PU_LEVEL, NULL);
+                plat = Z_PoolMalloc(&platpool, PU_LEVEL, NULL);
                 saveg_read_plat_t(plat);
                 plat->sector->floordata = plat;
                 P_AddThinker(&plat->thinker);
@@ -1469,7 +1603,7 @@ void P_UnArchiveSpecials(void)
 
             case tc_flash:
                 saveg_read_pad();
-                flash = Z_Malloc(sizeof(*flash), PU_LEVEL, NULL);
+                flash = Z_PoolMalloc(&lightflashpool, PU_LEVEL, NULL);
                 saveg_read_lightflash_t(flash);
                 flash->thinker.function = T_LightFlash;
                 P_AddThinker(&flash->thinker);
@@ -1477,7 +1611,7 @@ void P_UnArchiveSpecials(void)
 
             case tc_strobe:
                 saveg_read_pad();
-                strobe = Z_Malloc(sizeof(*strobe), PU_LEVEL, NULL);
+                strobe = Z_PoolMalloc(&strobepool, PU_LEVEL, NULL);
                 saveg_read_strobe_t(strobe);
                 strobe->thinker.function = T_StrobeFlash;
                 P_AddThinker(&strobe->thinker);
@@ -1485,7 +1619,7 @@ void P_UnArchiveSpecials(void)
 
             case tc_glow:
                 saveg_read_pad();
-                glow = Z_Malloc(sizeof(*glow), PU_LEVEL, NULL);
+                glow = Z_PoolMalloc(&glowpool, PU_LEVEL, NULL);
                 saveg_read_glow_t(glow);
                 glow->thinker.function = T_Glow;
                 P_AddThinker(&glow->thinker);
@@ -1493,7 +1627,7 @@ void P_UnArchiveSpecials(void)
 
             case tc_fireflicker:
                 saveg_read_pad();
-                fireflicker = Z_Malloc(sizeof(*fireflicker), PU_LEVEL, NULL);
+                fireflicker = Z_PoolMalloc(&fireflickerpool, PU_LEVEL, NULL);
                 saveg_read_fireflicker_t(fireflicker);
                 fireflicker->thinker.function = T_FireFlicker;
                 P_AddThinker(&fireflicker->thinker);
@@ -1501,7 +1635,7 @@ void P_UnArchiveSpecials(void)
 
             case tc_elevator:
                 saveg_read_pad();
-                elevator = Z_Malloc(sizeof(*elevator), PU_LEVEL, NULL);
+                elevator = Z_PoolMalloc(&elevatorpool, PU_LEVEL, NULL);
                 saveg_read_elevator_t(elevator);
                 elevator->sector->ceilingdata = elevator;
                 elevator->thinker.function = T_MoveElevator;
@@ -1510,7 +1644,7 @@ void P_UnArchiveSpecials(void)
 
             case tc_scroll:
                 saveg_read_pad();
-                scroll = Z_Malloc(sizeof(*scroll), PU_LEVEL, NULL);
+                scroll = Z_PoolMalloc(&scrollpool, PU_LEVEL, NULL);
                 saveg_read_scroll_t(scroll);
                 scroll->thinker.function = T_Scroll;
                 P_AddThinker(&scroll->thinker);
@@ -1518,7 +1652,7 @@ void P_UnArchiveSpecials(void)
 
             case tc_pusher:
                 saveg_read_pad();
-                pusher = Z_Malloc(sizeof(*pusher), PU_LEVEL, NULL);
+                pusher = Z_PoolMalloc(&pusherpool, PU_LEVEL, NULL);
                 saveg_read_pusher_t(pusher);
                 pusher->thinker.function = T_Pusher;
                 pusher->source = P_GetPushThing(pusher->affectee);
@@ -74,6 +74,13 @@ char *P_TempSaveGameFile(void);
 // filename to use for a savegame slot
 char *P_SaveGameFile(int slot);
 
+// [BH] Savegames are written into and read from memory, and saved and loaded in one go
+dboolean P_OpenSaveGame(char *filename);
+void P_CreateSaveGame(void);
+byte *P_TakeSaveGame(size_t *length);
+void P_FreeSaveGame(byte *buffer);
+size_t P_WriteSaveGame(char *filename, byte *buffer, size_t length);
+
 // Savegame file header read/write functions
 dboolean P_ReadSaveGameHeader(char *description);
 void P_WriteSaveGameHeader(char *description);
@@ -99,6 +106,4 @@ uint32_t P_ThinkerToIndex(thinker_t *thinker);
 thinker_t *P_IndexToThinker(uint32_t index);
 void P_RestoreTargets(void);
 
-extern FILE     *save_stream;
-
 #endif
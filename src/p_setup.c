@@ -37,6 +37,7 @@
 */
 
 #include <ctype.h>
+#include <math.h>
 
 #include "am_map.h"
 #include "c_console.h"
@@ -44,6 +45,7 @@
 #include "doomstat.h"
 #include "i_swap.h"
 #include "i_system.h"
+#include "i_timer.h"
 #include "m_argv.h"
 #include "m_bbox.h"
 #include "m_menu.h"
@@ -58,6 +60,8 @@
 #include "w_wad.h"
 #include "z_zone.h"
 
+#include "SDL.h"
+
 #define RMAPINFO_SCRIPT_NAME    "RMAPINFO"
 #define MAPINFO_SCRIPT_NAME     "MAPINFO"
 
@@ -150,8 +154,8 @@ int             *blockmaplump;
 fixed_t         bmaporgx;
 fixed_t         bmaporgy;
 
-// for thing chains
-mobj_t          **blocklinks;
+// [BH] for things in each block
+blockthings_t   *blockthings;
 
 dboolean        skipblstart;            // MaxW: Skip initial blocklist short
 
@@ -1704,7 +1708,7 @@ void P_LoadBlockMap(int lump)
             blockmaplump[i] = (t == -1 ? -1l : ((uint32_t)t & 0xFFFF));
         }
 
-        Z_Free(wadblockmaplump);
+        W_ReleaseLumpNum(lump);
 
         // Read the header
         bmaporgx = blockmaplump[0] << FRACBITS;
@@ -1721,10 +1725,621 @@ void P_LoadBlockMap(int lump)
     }
 
     // Clear out mobj chains
-    blocklinks = calloc_IfSameLevel(blocklinks, bmapwidth * bmapheight, sizeof(*blocklinks));
+    blockthings = calloc_IfSameLevel(blockthings, bmapwidth * bmapheight, sizeof(*blockthings));
     blockmap = blockmaplump + 4;
 }
 
+//
+// [BH] REJECT builder
+// Maps that have no REJECT lump, or one that is all zeros, get a table built for them
+//  here so P_CheckSight() can still skip sight checks between sectors that can never
+//  see each other. Two-sided lines are treated as portals whatever the heights of the
+//  sectors either side of them (since doors and lifts move), and a sector is marked as
+//  visible from another if any straight line can pass through the chain of portals
+//  between them. Every clip is given some slack to absorb the rounding in
+//  P_DivlineSide() and P_CrossBSPNode(), so a pair of sectors is only rejected when no
+//  sight check between them could ever succeed. Sectors with self-referencing lines or
+//  lines that don't form closed loops can be seen in ways portals can't describe, so
+//  are treated as visible to and from every sector they're connected to.
+//
+#define REJECTEPSILON   2.0
+#define REJECTBUDGET    (1 << 18)
+#define REJECTMAXDEPTH  1024
+
+#define REJECTID        "DRREJECT"
+#define REJECTVERSION   2
+
+typedef struct
+{
+    char                identification[8];
+    int                 version;
+    int                 numsectors;
+} rejectheader_t;
+
+typedef struct
+{
+    double              x1, y1;
+    double              x2, y2;
+} rejectseg_t;
+
+typedef struct
+{
+    rejectseg_t         seg;
+    int                 sector[2];
+} rejectportal_t;
+
+// [BH] a sector P_RejectFlow() has followed a portal into
+typedef struct
+{
+    rejectseg_t         pass;
+    int                 sector;
+    int                 next;
+    int                 portal;
+} rejectframe_t;
+
+typedef struct
+{
+    byte                *row;
+    byte                *onstack;
+    int                 *queue;
+    rejectframe_t       *stack;
+    int                 budget;
+} rejectworker_t;
+
+static rejectportal_t   *rejectportals;
+static int              *rejectsectorportals;
+static int              *rejectfirstportal;
+static byte             *rejectopen;
+static byte             *rejectrows;
+static int              rejectnumportals;
+static int              rejectrowsize;
+static SDL_atomic_t     rejectnextsector;
+
+//
+// P_RejectClipSeg
+// Clip seg to the side of the line from (ax, ay) to (bx, by) given by sign, keeping
+//  anything within REJECTEPSILON of it. Returns false if nothing is left.
+//
+static dboolean P_RejectClipSeg(rejectseg_t *seg, double ax, double ay, double bx, double by,
+    double sign)
+{
+    double      dx = bx - ax;
+    double      dy = by - ay;
+    double      length = sqrt(dx * dx + dy * dy);
+    double      d1, d2;
+
+    if (length < 1.0)
+        return true;
+
+    d1 = sign * (dx * (seg->y1 - ay) - dy * (seg->x1 - ax)) / length + REJECTEPSILON;
+    d2 = sign * (dx * (seg->y2 - ay) - dy * (seg->x2 - ax)) / length + REJECTEPSILON;
+
+    if (d1 < 0.0 && d2 < 0.0)
+        return false;
+
+    if (d1 < 0.0)
+    {
+        double  frac = d1 / (d1 - d2);
+
+        seg->x1 += (seg->x2 - seg->x1) * frac;
+        seg->y1 += (seg->y2 - seg->y1) * frac;
+    }
+    else if (d2 < 0.0)
+    {
+        double  frac = d2 / (d2 - d1);
+
+        seg->x2 += (seg->x1 - seg->x2) * frac;
+        seg->y2 += (seg->y1 - seg->y2) * frac;
+    }
+
+    return true;
+}
+
+//
+// P_RejectSide
+// Returns the distance of (x, y) from the line from (ax, ay) to (bx, by), signed by
+//  which side of it it's on.
+//
+static double P_RejectSide(double x, double y, double ax, double ay, double bx, double by)
+{
+    double      dx = bx - ax;
+    double      dy = by - ay;
+    double      length = sqrt(dx * dx + dy * dy);
+
+    return (length < 1.0 ? 0.0 : (dx * (y - ay) - dy * (x - ax)) / length);
+}
+
+//
+// P_RejectClip
+// Clip seg to the part of it that a straight line passing through both src and pass
+//  could reach. Returns false if no such line exists.
+//
+static dboolean P_RejectClip(rejectseg_t *seg, const rejectseg_t *src, const rejectseg_t *pass)
+{
+    double      ax[2] = { src->x1, src->x2 };
+    double      ay[2] = { src->y1, src->y2 };
+    double      bx[2] = { pass->x1, pass->x2 };
+    double      by[2] = { pass->y1, pass->y2 };
+    double      d1 = P_RejectSide(ax[0], ay[0], bx[0], by[0], bx[1], by[1]);
+    double      d2 = P_RejectSide(ax[1], ay[1], bx[0], by[0], bx[1], by[1]);
+    int         i, j;
+
+    // if src is entirely on one side of pass, only what is on the other side can be seen
+    if ((d1 > REJECTEPSILON && d2 > REJECTEPSILON) || (d1 < -REJECTEPSILON && d2 < -REJECTEPSILON))
+        if (!P_RejectClipSeg(seg, bx[0], by[0], bx[1], by[1], (d1 > 0.0 ? -1.0 : 1.0)))
+            return false;
+
+    // clip against the separating lines, that have src on one side and pass on the other
+    for (i = 0; i < 2; i++)
+        for (j = 0; j < 2; j++)
+        {
+            double  da = P_RejectSide(ax[i ^ 1], ay[i ^ 1], ax[i], ay[i], bx[j], by[j]);
+            double  db = P_RejectSide(bx[j ^ 1], by[j ^ 1], ax[i], ay[i], bx[j], by[j]);
+
+            if ((da > REJECTEPSILON && db < -REJECTEPSILON) || (da < -REJECTEPSILON && db > REJECTEPSILON))
+                if (!P_RejectClipSeg(seg, ax[i], ay[i], bx[j], by[j], (db > 0.0 ? 1.0 : -1.0)))
+                    return false;
+        }
+
+    return true;
+}
+
+//
+// P_RejectFlow
+// Follow every portal out of sector that can be seen through both src and pass, and
+//  out of the sectors beyond them, keeping the sectors followed on the worker's stack.
+//
+static void P_RejectFlow(rejectworker_t *worker, const rejectseg_t *src, const rejectseg_t *pass,
+    int sector)
+{
+    rejectframe_t   *stack = worker->stack;
+    int             depth = 0;
+
+    stack[0].pass = *pass;
+    stack[0].sector = sector;
+    stack[0].next = rejectfirstportal[sector];
+    stack[0].portal = -1;
+
+    while (depth >= 0 && worker->budget > 0)
+    {
+        rejectframe_t   *frame = &stack[depth];
+        int             p;
+        rejectportal_t  *portal;
+        int             other;
+        rejectseg_t     seg;
+
+        // every portal out of this sector has been followed, so back out of it
+        if (frame->next >= rejectfirstportal[frame->sector + 1])
+        {
+            if (frame->portal >= 0)
+                worker->onstack[frame->portal] = false;
+
+            depth--;
+            continue;
+        }
+
+        p = rejectsectorportals[frame->next++];
+        portal = &rejectportals[p];
+        other = portal->sector[portal->sector[0] == frame->sector];
+        seg = portal->seg;
+
+        if (worker->onstack[p] || other == frame->sector)
+            continue;
+
+        worker->budget--;
+
+        if (!P_RejectClip(&seg, src, &frame->pass))
+            continue;
+
+        worker->row[other >> 3] |= 1 << (other & 7);
+
+        if (depth == REJECTMAXDEPTH - 1)
+        {
+            worker->budget = 0;
+            break;
+        }
+
+        worker->onstack[p] = true;
+        frame = &stack[++depth];
+        frame->pass = seg;
+        frame->sector = other;
+        frame->next = rejectfirstportal[other];
+        frame->portal = p;
+    }
+
+    // leave the portals of any sectors not backed out of yet as they were
+    for (; depth >= 0; depth--)
+        if (stack[depth].portal >= 0)
+            worker->onstack[stack[depth].portal] = false;
+}
+
+//
+// P_RejectSector
+// Find every sector that could be seen from sector.
+//
+static void P_RejectSector(rejectworker_t *worker, int sector)
+{
+    int i, j;
+
+    worker->row = rejectrows + sector * rejectrowsize;
+    worker->row[sector >> 3] |= 1 << (sector & 7);
+    worker->budget = (rejectopen[sector] ? 0 : REJECTBUDGET);
+
+    for (i = rejectfirstportal[sector]; i < rejectfirstportal[sector + 1] && worker->budget > 0; i++)
+    {
+        int             p1 = rejectsectorportals[i];
+        rejectportal_t  *portal1 = &rejectportals[p1];
+        int             next = portal1->sector[portal1->sector[0] == sector];
+
+        if (next == sector)
+            continue;
+
+        // anything on the other side of a portal out of this sector can be seen
+        worker->row[next >> 3] |= 1 << (next & 7);
+        worker->onstack[p1] = true;
+
+        for (j = rejectfirstportal[next]; j < rejectfirstportal[next + 1] && worker->budget > 0; j++)
+        {
+            int             p2 = rejectsectorportals[j];
+            rejectportal_t  *portal2 = &rejectportals[p2];
+            int             other = portal2->sector[portal2->sector[0] == next];
+
+            if (worker->onstack[p2] || other == next)
+                continue;
+
+            // and so can anything on the other side of the portals out of that sector
+            worker->row[other >> 3] |= 1 << (other & 7);
+            worker->onstack[p2] = true;
+            P_RejectFlow(worker, &portal1->seg, &portal2->seg, other);
+            worker->onstack[p2] = false;
+        }
+
+        worker->onstack[p1] = false;
+    }
+
+    // too much work, or a sector portals can't describe, so fall back to everything
+    //  connected to this sector
+    if (worker->budget <= 0)
+    {
+        int head = 0;
+        int tail = 0;
+
+        memset(worker->onstack, 0, rejectnumportals);
+        worker->queue[tail++] = sector;
+
+        while (head < tail)
+        {
+            int s = worker->queue[head++];
+
+            for (i = rejectfirstportal[s]; i < rejectfirstportal[s + 1]; i++)
+            {
+                int             p = rejectsectorportals[i];
+                rejectportal_t  *portal = &rejectportals[p];
+                int             other = portal->sector[portal->sector[0] == s];
+
+                if (worker->onstack[p])
+                    continue;
+
+                worker->onstack[p] = true;
+                worker->row[other >> 3] |= 1 << (other & 7);
+                worker->queue[tail++] = other;
+            }
+        }
+
+        memset(worker->onstack, 0, rejectnumportals);
+    }
+}
+
+static int SDLCALL P_RejectThread(void *data)
+{
+    rejectworker_t  *worker = data;
+    int             sector;
+
+    while ((sector = SDL_AtomicAdd(&rejectnextsector, 1)) < numsectors)
+        P_RejectSector(worker, sector);
+
+    return 0;
+}
+
+//
+// P_RejectHash
+// Hash the geometry a REJECT table is built from, to name its cache file.
+//
+static uint64_t P_RejectHash(void)
+{
+    uint64_t    hash = 14695981039346656037ull;
+    int         i;
+
+#define HASH(x) { int value = (x), k; for (k = 0; k < 4; k++, value >>= 8) \
+                    hash = (hash ^ (value & 0xFF)) * 1099511628211ull; }
+
+    HASH(numsectors);
+    HASH(numlines);
+
+    for (i = 0; i < numlines; i++)
+    {
+        line_t  *line = &lines[i];
+
+        HASH(line->v1->x);
+        HASH(line->v1->y);
+        HASH(line->v2->x);
+        HASH(line->v2->y);
+        HASH(line->flags & ML_TWOSIDED);
+        HASH(line->frontsector ? line->frontsector - sectors : -1);
+        HASH(line->backsector ? line->backsector - sectors : -1);
+    }
+
+#undef HASH
+
+    return hash;
+}
+
+//
+// P_RejectVertexCompare
+//
+static int P_RejectVertexCompare(const void *a, const void *b)
+{
+    uint64_t    x = *(const uint64_t *)a;
+    uint64_t    y = *(const uint64_t *)b;
+
+    return ((x > y) - (x < y));
+}
+
+//
+// P_FindOpenRejectSectors
+// Mark the sectors that have self-referencing lines, or whose lines don't all join
+//  up into closed loops, which is when a vertex is used by an odd number of them.
+//  Returns false if there isn't enough memory to check.
+//
+static dboolean P_FindOpenRejectSectors(void)
+{
+    uint64_t    *ends = malloc(numlines * 4 * sizeof(*ends));
+    int         numends = 0;
+    int         i;
+
+    if (!ends)
+        return false;
+
+    for (i = 0; i < numlines; i++)
+    {
+        line_t  *line = &lines[i];
+        int     j;
+
+        if (line->frontsector && line->frontsector == line->backsector)
+        {
+            rejectopen[line->frontsector - sectors] = true;
+            continue;
+        }
+
+        for (j = 0; j < 2; j++)
+        {
+            sector_t    *sector = (j ? line->backsector : line->frontsector);
+
+            if (sector)
+            {
+                uint64_t    key = (uint64_t)(sector - sectors) << 32;
+
+                ends[numends++] = key | (uint64_t)(line->v1 - vertexes);
+                ends[numends++] = key | (uint64_t)(line->v2 - vertexes);
+            }
+        }
+    }
+
+    qsort(ends, numends, sizeof(*ends), P_RejectVertexCompare);
+
+    for (i = 0; i < numends;)
+    {
+        int j = i;
+
+        while (j < numends && ends[j] == ends[i])
+            j++;
+
+        if ((j - i) & 1)
+            rejectopen[ends[i] >> 32] = true;
+
+        i = j;
+    }
+
+    free(ends);
+    return true;
+}
+
+//
+// P_FreeReject
+//
+static void P_FreeReject(rejectworker_t *workers, int numworkers)
+{
+    int i;
+
+    if (workers)
+    {
+        for (i = 0; i < numworkers; i++)
+        {
+            free(workers[i].onstack);
+            free(workers[i].queue);
+            free(workers[i].stack);
+        }
+
+        free(workers);
+    }
+
+    free(rejectopen);
+    free(rejectrows);
+    free(rejectsectorportals);
+    free(rejectfirstportal);
+    free(rejectportals);
+
+    rejectopen = NULL;
+    rejectrows = NULL;
+    rejectsectorportals = NULL;
+    rejectfirstportal = NULL;
+    rejectportals = NULL;
+}
+
+//
+// P_BuildReject
+//
+static byte *P_BuildReject(void)
+{
+    unsigned int    required = (numsectors * numsectors + 7) / 8;
+    byte            *reject = Z_Calloc(1, required, PU_LEVEL, NULL);
+    static char     *folder;
+    char            filename[MAX_PATH];
+    FILE            *file;
+    rejectheader_t  header;
+    uint64_t        start = I_GetTimeUS();
+    int             *fill;
+    int             numworkers = BETWEEN(1, SDL_GetCPUCount(), 16);
+    rejectworker_t  *workers = NULL;
+    SDL_Thread      **threads;
+    int             i, j;
+
+    if (!folder)
+    {
+        folder = M_StringJoin(M_GetAppDataFolder(), DIR_SEPARATOR_S, "reject", DIR_SEPARATOR_S, NULL);
+        M_MakeDirectory(folder);
+    }
+
+    M_snprintf(filename, sizeof(filename), "%s%016" PRIx64 ".rej", folder, P_RejectHash());
+
+    if ((file = fopen(filename, "rb")))
+    {
+        if (fread(&header, sizeof(header), 1, file) == 1
+            && !memcmp(header.identification, REJECTID, sizeof(header.identification))
+            && header.version == REJECTVERSION && header.numsectors == numsectors
+            && fread(reject, 1, required, file) == required)
+        {
+            fclose(file);
+            C_Output("This map's missing <b>REJECT</b> lump was loaded from <b>%s</b>.", filename);
+            return reject;
+        }
+
+        fclose(file);
+        memset(reject, 0, required);
+    }
+
+    // gather the portals, and the portals out of each sector
+    rejectnumportals = 0;
+    rejectportals = malloc(MAX(1, numlines) * sizeof(*rejectportals));
+    rejectfirstportal = calloc(numsectors + 1, sizeof(*rejectfirstportal));
+    rejectsectorportals = malloc(MAX(1, numlines) * 2 * sizeof(*rejectsectorportals));
+    rejectrowsize = (numsectors + 7) / 8;
+    rejectrows = calloc(numsectors, rejectrowsize);
+    rejectopen = calloc(numsectors, 1);
+
+    // [BH] if there isn't enough memory, just don't reject anything
+    if (!rejectportals || !rejectfirstportal || !rejectsectorportals || !rejectrows || !rejectopen
+        || !P_FindOpenRejectSectors())
+    {
+        P_FreeReject(NULL, 0);
+        return reject;
+    }
+
+    for (i = 0; i < numlines; i++)
+    {
+        line_t  *line = &lines[i];
+
+        if ((line->flags & ML_TWOSIDED) && line->frontsector && line->backsector)
+        {
+            rejectportal_t  *portal = &rejectportals[rejectnumportals++];
+
+            portal->seg.x1 = (double)line->v1->x / FRACUNIT;
+            portal->seg.y1 = (double)line->v1->y / FRACUNIT;
+            portal->seg.x2 = (double)line->v2->x / FRACUNIT;
+            portal->seg.y2 = (double)line->v2->y / FRACUNIT;
+            portal->sector[0] = line->frontsector - sectors;
+            portal->sector[1] = line->backsector - sectors;
+            rejectfirstportal[portal->sector[0] + 1]++;
+            rejectfirstportal[portal->sector[1] + 1]++;
+        }
+    }
+
+    for (i = 0; i < numsectors; i++)
+        rejectfirstportal[i + 1] += rejectfirstportal[i];
+
+    if (!(fill = malloc(numsectors * sizeof(*fill))))
+    {
+        P_FreeReject(NULL, 0);
+        return reject;
+    }
+
+    memcpy(fill, rejectfirstportal, numsectors * sizeof(*fill));
+
+    for (i = 0; i < rejectnumportals; i++)
+    {
+        rejectsectorportals[fill[rejectportals[i].sector[0]]++] = i;
+        rejectsectorportals[fill[rejectportals[i].sector[1]]++] = i;
+    }
+
+    free(fill);
+
+    // spread the sectors across as many threads as there are cores
+    if (!(workers = calloc(numworkers, sizeof(*workers)))
+        || !(threads = calloc(numworkers, sizeof(*threads))))
+    {
+        P_FreeReject(workers, 0);
+        return reject;
+    }
+
+    for (i = 0; i < numworkers; i++)
+    {
+        workers[i].onstack = calloc(MAX(1, rejectnumportals), 1);
+        workers[i].queue = malloc((rejectnumportals + 1) * sizeof(int));
+        workers[i].stack = malloc(REJECTMAXDEPTH * sizeof(rejectframe_t));
+
+        if (!workers[i].onstack || !workers[i].queue || !workers[i].stack)
+        {
+            free(threads);
+            P_FreeReject(workers, i + 1);
+            return reject;
+        }
+    }
+
+    SDL_AtomicSet(&rejectnextsector, 0);
+
+    for (i = 1; i < numworkers; i++)
+        threads[i] = SDL_CreateThread(P_RejectThread, "P_RejectThread", &workers[i]);
+
+    P_RejectThread(&workers[0]);
+
+    for (i = 1; i < numworkers; i++)
+        if (threads[i])
+            SDL_WaitThread(threads[i], NULL);
+
+    // a sector can see another if either can see the other
+    for (i = 0; i < numsectors; i++)
+    {
+        byte    *row = rejectrows + i * rejectrowsize;
+
+        for (j = 0; j < numsectors; j++)
+            if (!(row[j >> 3] & (1 << (j & 7)))
+                && !(rejectrows[j * rejectrowsize + (i >> 3)] & (1 << (i & 7))))
+            {
+                int pnum = i * numsectors + j;
+
+                reject[pnum >> 3] |= 1 << (pnum & 7);
+            }
+    }
+
+    free(threads);
+    P_FreeReject(workers, numworkers);
+
+    if ((file = fopen(filename, "wb")))
+    {
+        memcpy(header.identification, REJECTID, sizeof(header.identification));
+        header.version = REJECTVERSION;
+        header.numsectors = numsectors;
+        fwrite(&header, sizeof(header), 1, file);
+        fwrite(reject, 1, required, file);
+        fclose(file);
+    }
+
+    C_Output("This map's missing <b>REJECT</b> lump was built in %s milliseconds using %i thread%s.",
+        striptrailingzero((I_GetTimeUS() - start) / 1000.0f, 1), numworkers, (numworkers == 1 ? "" : "s"));
+
+    return reject;
+}
+
 //
 // reject overrun emulation
 //
@@ -1760,6 +2375,22 @@ static void P_LoadReject(int lumpnum, int totallines)
 
     // e6y: check for overflow
     RejectOverrun(rejectlump, &rejectmatrix, totallines);
+
+    // [BH] build a REJECT table if there isn't one
+    {
+        unsigned int    required = (numsectors * numsectors + 7) / 8;
+        unsigned int    i;
+
+        for (i = 0; i < required; i++)
+            if (rejectmatrix[i])
+                return;
+
+        if (W_LumpLength(rejectlump) >= required)
+            W_ReleaseLumpNum(rejectlump);
+
+        rejectlump = -1;
+        rejectmatrix = P_BuildReject();
+    }
 }
 
 //
@@ -2184,7 +2815,9 @@ void P_SetupLevel(int ep, int map)
 
     idclev = false;
 
+    P_FreeBloodSplats();
     Z_FreeTags(PU_LEVEL, PU_PURGELEVEL - 1);
+    P_FreeBlockThings();
 
     if (rejectlump != -1)
     {
@@ -2194,6 +2827,7 @@ void P_SetupLevel(int ep, int map)
     }
 
     P_InitThinkers();
+    P_ResetSightCache();
 
     // find map name
     if (gamemode == commercial)
@@ -2235,7 +2869,7 @@ void P_SetupLevel(int ep, int map)
         free(segs);
         free(nodes);
         free(subsectors);
-        free(blocklinks);
+        free(blockthings);
         free(blockmaplump);
         free(lines);
         free(sides);
@@ -2254,7 +2888,7 @@ void P_SetupLevel(int ep, int map)
     if (!samelevel)
         P_LoadBlockMap(lumpnum + ML_BLOCKMAP);
     else
-        memset(blocklinks, 0, bmapwidth * bmapheight * sizeof(*blocklinks));
+        memset(blockthings, 0, bmapwidth * bmapheight * sizeof(*blockthings));
 
     if (mapformat == ZDBSPX)
         P_LoadZNodes(lumpnum + ML_NODES);
@@ -2274,13 +2908,12 @@ void P_SetupLevel(int ep, int map)
     // reject loading and underflow padding separated out into new function
     // P_GroupLines modified to return a number the underflow padding needs
     P_LoadReject(lumpnum, P_GroupLines());
+    P_BuildSoundGraph();
 
     P_RemoveSlimeTrails();
 
     P_CalcSegsLength();
 
-    r_bloodsplats_total = 0;
-
     pathpointnum = 0;
     pathpointnum_max = 0;
 
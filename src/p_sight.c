@@ -36,6 +36,8 @@
 ========================================================================
 */
 
+#include <string.h>
+
 #include "m_bbox.h"
 #include "p_local.h"
 
@@ -56,6 +58,55 @@ typedef struct
 
 static los_t    los; // cph - made static
 
+// [BH] The results of the sight checks made so far this tic. An entry is only used if
+//  neither thing has moved and no sector has changed height since it was made, so the
+//  result is always what tracing the line of sight again would have returned.
+#define SIGHTCACHESIZE  1024
+
+typedef struct
+{
+    mobj_t              *t1, *t2;
+    subsector_t         *subsector1, *subsector2;
+    fixed_t             x1, y1, z1, height1;
+    fixed_t             x2, y2, z2, height2;
+    unsigned int        generation;
+    dboolean            result;
+} sightcache_t;
+
+static sightcache_t     sightcache[SIGHTCACHESIZE];
+static unsigned int     sightcachegeneration = 1;
+
+int                     sightcachehits;
+int                     sightcachemisses;
+
+// [BH] counted for -simulate
+int                     checksightcalls;
+
+//
+// P_ClearSightCache
+// Called at the end of every tic, and whenever a sector changes height.
+//
+void P_ClearSightCache(void)
+{
+    if (!++sightcachegeneration)
+    {
+        memset(sightcache, 0, sizeof(sightcache));
+        sightcachegeneration = 1;
+    }
+}
+
+//
+// P_ResetSightCache
+// Called when a map is loaded.
+//
+void P_ResetSightCache(void)
+{
+    memset(sightcache, 0, sizeof(sightcache));
+    sightcachegeneration = 1;
+    sightcachehits = 0;
+    sightcachemisses = 0;
+}
+
 //
 // P_DivlineSide
 // Returns side 0 (front), 1 (back), or 2 (on).
@@ -237,6 +288,9 @@ dboolean P_CheckSight(mobj_t *t1, mobj_t *t2)
     const sector_t      *s1 = t1->subsector->sector;
     const sector_t      *s2 = t2->subsector->sector;
     int                 pnum = (int)(s1 - sectors) * numsectors + (int)(s2 - sectors);
+    sightcache_t        *cache;
+
+    checksightcalls++;
 
     // First check for trivial rejection.
     // Determine subsector entries in REJECT table.
@@ -262,6 +316,20 @@ dboolean P_CheckSight(mobj_t *t1, mobj_t *t2)
     if (t1->subsector == t2->subsector)
         return true;
 
+    // [BH] check if the same sight check has already been made this tic
+    cache = &sightcache[(((uintptr_t)t1 >> 4) ^ ((uintptr_t)t2 >> 2) * 31) & (SIGHTCACHESIZE - 1)];
+
+    if (cache->generation == sightcachegeneration && cache->t1 == t1 && cache->t2 == t2
+        && cache->subsector1 == t1->subsector && cache->subsector2 == t2->subsector
+        && cache->x1 == t1->x && cache->y1 == t1->y && cache->z1 == t1->z && cache->height1 == t1->height
+        && cache->x2 == t2->x && cache->y2 == t2->y && cache->z2 == t2->z && cache->height2 == t2->height)
+    {
+        sightcachehits++;
+        return cache->result;
+    }
+
+    sightcachemisses++;
+
     // An unobstructed LOS is possible.
     // Now look from eyes of t1 to any part of t2.
     validcount++;
@@ -300,5 +368,19 @@ dboolean P_CheckSight(mobj_t *t1, mobj_t *t2)
     }
 
     // the head node is the last node output
-    return P_CrossBSPNode(numnodes - 1);
+    cache->t1 = t1;
+    cache->t2 = t2;
+    cache->subsector1 = t1->subsector;
+    cache->subsector2 = t2->subsector;
+    cache->x1 = t1->x;
+    cache->y1 = t1->y;
+    cache->z1 = t1->z;
+    cache->height1 = t1->height;
+    cache->x2 = t2->x;
+    cache->y2 = t2->y;
+    cache->z2 = t2->z;
+    cache->height2 = t2->height;
+    cache->generation = sightcachegeneration;
+
+    return (cache->result = P_CrossBSPNode(numnodes - 1));
 }
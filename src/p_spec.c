@@ -2023,7 +2023,7 @@ dboolean EV_DoDonut(line_t *line)
             rtn = true;
 
             // Spawn rising slime
-            floor = Z_Calloc(1, sizeof(*floor), PU_LEVSPEC, NULL);
+            floor = Z_PoolCalloc(&floorpool, PU_LEVSPEC, NULL);
             P_AddThinker(&floor->thinker);
             s2->floordata = floor;
             floor->thinker.function = T_MoveFloor;
@@ -2038,7 +2038,7 @@ dboolean EV_DoDonut(line_t *line)
             floor->stopsound = (floor->sector->floorheight != floor->floordestheight);
 
             // Spawn lowering donut-hole
-            floor = Z_Calloc(1, sizeof(*floor), PU_LEVSPEC, NULL);
+            floor = Z_PoolCalloc(&floorpool, PU_LEVSPEC, NULL);
             P_AddThinker(&floor->thinker);
             s1->floordata = floor;
             floor->thinker.function = T_MoveFloor;
@@ -2302,6 +2302,7 @@ void T_Scroll(scroll_t *s)
                 if (!(thing->flags & MF_NOCLIP) && (!((thing->flags & MF_NOGRAVITY)
                     || thing->z > height) || thing->z < waterheight))
                 {
+                    P_WakeMobj(thing);
                     thing->momx += dx;
                     thing->momy += dy;
                 }
@@ -2332,7 +2333,7 @@ void T_Scroll(scroll_t *s)
 //
 static void Add_Scroller(int type, fixed_t dx, fixed_t dy, int control, int affectee, int accel)
 {
-    scroll_t    *s = Z_Calloc(1, sizeof(*s), PU_LEVSPEC, NULL);
+    scroll_t    *s = Z_PoolCalloc(&scrollpool, PU_LEVSPEC, NULL);
 
     s->thinker.function = T_Scroll;
     s->type = type;
@@ -2606,7 +2607,7 @@ static void P_SpawnFriction(void)
 // Add a push thinker to the thinker list
 static void Add_Pusher(int type, int x_mag, int y_mag, mobj_t *source, int affectee)
 {
-    pusher_t    *p = Z_Calloc(1, sizeof(*p), PU_LEVSPEC, NULL);
+    pusher_t    *p = Z_PoolCalloc(&pusherpool, PU_LEVSPEC, NULL);
 
     p->thinker.function = T_Pusher;
     p->source = source;
@@ -2668,6 +2669,7 @@ dboolean PIT_PushThing(mobj_t *thing)
             if (tmpusher->source->type == MT_PUSH)
                 pushangle += ANG180;    // away
             pushangle >>= ANGLETOFINESHIFT;
+            P_WakeMobj(thing);
             thing->momx += FixedMul(speed, finecosine[pushangle]);
             thing->momy += FixedMul(speed, finesine[pushangle]);
         }
@@ -2792,6 +2794,7 @@ void T_Pusher(pusher_t *p)
                     yspeed = p->y_mag;
                 }
         }
+        P_WakeMobj(thing);
         thing->momx += xspeed << (FRACBITS - PUSH_FACTOR);
         thing->momy += yspeed << (FRACBITS - PUSH_FACTOR);
     }
@@ -38,6 +38,8 @@
 
 #include "c_console.h"
 #include "doomstat.h"
+#include "i_timer.h"
+#include "m_config.h"
 #include "p_local.h"
 #include "p_tick.h"
 #include "s_sound.h"
@@ -46,6 +48,18 @@
 int             leveltime;
 unsigned int    stat_time;
 
+dboolean        sleepthinkers = sleepthinkers_default;
+int             sleepingthinkers;
+
+static unsigned int     thinkerorder;
+static dboolean         thinkersrunning;
+static dboolean         thinkersrun;
+
+// [BH] -simulate
+dboolean        timethinkers;
+thinkertime_t   thinkertimes[MAXTHINKERTIMES];
+int             numthinkertimes;
+
 //
 // THINKERS
 // All thinkers should be allocated by Z_Malloc
@@ -54,6 +68,21 @@ unsigned int    stat_time;
 // but the first element must be thinker_t.
 //
 
+// [BH] Each class of thinker is allocated from its own pool, so thinkers of the same
+//  class are close together in memory, and are released together when the map ends.
+zpool_t         ceilingpool = ZPOOL("ceilings", ceiling_t);
+zpool_t         doorpool = ZPOOL("doors", vldoor_t);
+zpool_t         elevatorpool = ZPOOL("elevators", elevator_t);
+zpool_t         fireflickerpool = ZPOOL("fire flickers", fireflicker_t);
+zpool_t         floorpool = ZPOOL("floors", floormove_t);
+zpool_t         glowpool = ZPOOL("glows", glow_t);
+zpool_t         lightflashpool = ZPOOL("light flashes", lightflash_t);
+zpool_t         mobjpool = ZPOOL("things", mobj_t);
+zpool_t         platpool = ZPOOL("platforms", plat_t);
+zpool_t         pusherpool = ZPOOL("pushers", pusher_t);
+zpool_t         scrollpool = ZPOOL("scrollers", scroll_t);
+zpool_t         strobepool = ZPOOL("strobes", strobe_t);
+
 // killough 8/29/98: we maintain several separate threads, each containing
 // a special class of thinkers, to allow more efficient searches.
 thinker_t       thinkerclasscap[th_all + 1];
@@ -70,6 +99,7 @@ void P_InitThinkers(void)
         thinkerclasscap[i].cprev = thinkerclasscap[i].cnext = &thinkerclasscap[i];
 
     thinkercap.prev = thinkercap.next = &thinkercap;
+    sleepingthinkers = 0;
 }
 
 //
@@ -110,6 +140,8 @@ void P_AddThinker(thinker_t *thinker)
     thinkercap.prev = thinker;
 
     thinker->references = 0;    // killough 11/98: init reference counter to 0
+    thinker->order = thinkerorder++;
+    thinker->sleeping = false;
 
     // killough 8/29/98: set sentinel pointers, and then add to appropriate list
     thinker->cnext = thinker->cprev = NULL;
@@ -214,21 +246,97 @@ void P_SetTarget(mobj_t **mop, mobj_t *targ)
 // Rewritten to delete nodes implicitly, by making currentthinker
 // external and using P_RemoveThinkerDelayed() implicitly.
 //
-static void P_RunThinkers(void)
+// [BH] Sleeping thinkers are skipped, but keep their place in the list, so they are still
+//  run in the same order once they wake.
+//
+static thinkertime_t *P_GetThinkerTime(think_t function)
 {
-    currentthinker = thinkercap.next;
+    int i;
+
+    for (i = 0; i < numthinkertimes; i++)
+        if (thinkertimes[i].function == function)
+            return &thinkertimes[i];
+
+    // [BH] any more types of thinker than expected share the last entry
+    if (numthinkertimes == MAXTHINKERTIMES)
+        return &thinkertimes[MAXTHINKERTIMES - 1];
+
+    thinkertimes[numthinkertimes].function = function;
+    return &thinkertimes[numthinkertimes++];
+}
+
+// [BH] Same as the loop in P_RunThinkers(), but keeps the time spent in each type of thinker.
+//  The clock is only read when the type changes, and the whole time since is given to the
+//  type before, so the times still add up to the time spent in the loop.
+static void P_RunTimedThinkers(void)
+{
+    thinkertime_t   *time = NULL;
+    uint64_t        start = I_GetTimeUS();
 
     while (currentthinker != &thinkercap)
     {
-        if (currentthinker->function)
-            currentthinker->function(currentthinker);
+        think_t function = currentthinker->function;
+
+        if (function && !currentthinker->sleeping)
+        {
+            if (!time || time->function != function)
+            {
+                uint64_t    now = I_GetTimeUS();
+
+                if (time)
+                    time->time += now - start;
+
+                start = now;
+                time = P_GetThinkerTime(function);
+            }
+
+            function(currentthinker);
+            time->calls++;
+        }
+
         currentthinker = currentthinker->next;
     }
 
+    if (time)
+        time->time += I_GetTimeUS() - start;
+}
+
+static void P_RunThinkers(void)
+{
+    P_WakeLookingMobjs();
+
+    thinkersrunning = true;
+    currentthinker = thinkercap.next;
+
+    if (timethinkers)
+        P_RunTimedThinkers();
+    else
+        while (currentthinker != &thinkercap)
+        {
+            if (currentthinker->function && !currentthinker->sleeping)
+                currentthinker->function(currentthinker);
+            currentthinker = currentthinker->next;
+        }
+
+    thinkersrunning = false;
+    thinkersrun = true;
+
     // Dedicated thinkers
     T_MAPMusic();
 }
 
+//
+// P_LastThinkerTic
+// [BH] Returns the last tic in which thinker has had its turn in P_RunThinkers().
+//
+int P_LastThinkerTic(thinker_t *thinker)
+{
+    if (thinkersrunning)
+        return (thinker->order < currentthinker->order ? leveltime : leveltime - 1);
+    else
+        return (thinkersrun ? leveltime : leveltime - 1);
+}
+
 //
 // P_Ticker
 //
@@ -246,7 +354,10 @@ void P_Ticker(void)
 
     P_MapEnd();
 
+    P_ClearSightCache();
+
     // for par times
     leveltime++;
     stat_time = SafeAdd(stat_time, 1);
+    thinkersrun = false;
 }
@@ -43,6 +43,8 @@
 #pragma interface
 #endif
 
+#include "z_zone.h"
+
 void P_Ticker(void);
 
 void P_InitThinkers(void);
@@ -54,6 +56,8 @@ void P_UpdateThinker(thinker_t *thinker);               // killough 8/29/98
 
 void P_SetTarget(mobj_t **mo, mobj_t *target);          // killough 11/98
 
+int P_LastThinkerTic(thinker_t *thinker);
+
 // killough 8/29/98: threads of thinkers, for more efficient searches
 // cph 2002/01/13: for consistency with the main thinker list, keep objects
 // pending deletion on a class list too
@@ -68,6 +72,37 @@ typedef enum
 
 extern thinker_t        thinkerclasscap[];
 
+// [BH] pools that each class of thinker is allocated from
+extern zpool_t          ceilingpool;
+extern zpool_t          doorpool;
+extern zpool_t          elevatorpool;
+extern zpool_t          fireflickerpool;
+extern zpool_t          floorpool;
+extern zpool_t          glowpool;
+extern zpool_t          lightflashpool;
+extern zpool_t          mobjpool;
+extern zpool_t          platpool;
+extern zpool_t          pusherpool;
+extern zpool_t          scrollpool;
+extern zpool_t          strobepool;
+
 #define thinkercap      thinkerclasscap[th_all]
 
+extern dboolean         sleepthinkers;
+extern int              sleepingthinkers;
+
+// [BH] time spent in each type of thinker, kept by -simulate
+#define MAXTHINKERTIMES 32
+
+typedef struct
+{
+    think_t             function;
+    uint64_t            time;
+    int                 calls;
+} thinkertime_t;
+
+extern dboolean         timethinkers;
+extern thinkertime_t    thinkertimes[MAXTHINKERTIMES];
+extern int              numthinkertimes;
+
 #endif
@@ -240,6 +240,11 @@ static void P_DeathThink(player_t *player)
 
     weaponvibrationtics = 1;
     idlemotorspeed = 0;
+
+    // [BH] monsters sleeping in A_Look() may now look for each other
+    if (!infight)
+        P_WakeMobjs();
+
     infight = true;
 
     P_MovePsprites(player);
@@ -43,21 +43,90 @@
 #include "r_main.h"
 #include "r_plane.h"
 #include "r_things.h"
+#include "z_zone.h"
 
-seg_t           *curline;
-side_t          *sidedef;
-line_t          *linedef;
-sector_t        *frontsector;
-sector_t        *backsector;
+THREADLOCAL seg_t               *curline;
+THREADLOCAL side_t              *sidedef;
+THREADLOCAL line_t              *linedef;
+THREADLOCAL sector_t            *frontsector;
+THREADLOCAL sector_t            *backsector;
 
-dboolean        doorclosed;
+THREADLOCAL dboolean            doorclosed;
 
-drawseg_t       *drawsegs;
-unsigned int    maxdrawsegs;
-drawseg_t       *ds_p;
+THREADLOCAL drawseg_t           *drawsegs;
+THREADLOCAL unsigned int        maxdrawsegs;
+THREADLOCAL drawseg_t           *ds_p;
+
+// [BH] the ranges of columns of each seg R_FindVisibleSubsectors() found were
+//  visible once clipped against the whole view
+typedef struct
+{
+    seg_t                       *seg;
+    int                         start;
+    int                         stop;
+    dboolean                    doorclosed;
+} visiblewall_t;
+
+// [BH] the subsectors R_FindVisibleSubsectors() found, front to back, with the
+//  columns their segs were drawn in, so each render strip only has to redo these
+typedef struct
+{
+    int                         num;
+    int                         x1;
+    int                         x2;
+    int                         firstwall;
+    int                         numwalls;
+} visiblesubsector_t;
+
+static visiblesubsector_t       *visiblesubsectors;
+static int                      numvisiblesubsectors;
+static int                      maxvisiblesubsectors;
+static visiblewall_t            *visiblewalls;
+static int                      numvisiblewalls;
+static int                      maxvisiblewalls;
+static dboolean                 findingsubsectors;
+
+extern fixed_t                  animatedliquidxoffs;
+extern fixed_t                  animatedliquidyoffs;
+extern dboolean                 r_liquid_current;
 
 void R_StoreWallRange(int start, int stop);
 
+//
+// R_AddWallRange
+// [BH] Draw the given columns of the current seg, or if only finding the visible
+//  subsectors, add them to the current subsector's walls instead.
+//
+static void R_AddWallRange(int start, int stop)
+{
+    if (findingsubsectors)
+    {
+        visiblesubsector_t  *sub = &visiblesubsectors[numvisiblesubsectors - 1];
+        visiblewall_t       *wall;
+
+        if (numvisiblewalls == maxvisiblewalls)
+        {
+            maxvisiblewalls = (maxvisiblewalls ? 2 * maxvisiblewalls : 256);
+            visiblewalls = Z_Realloc(visiblewalls, maxvisiblewalls * sizeof(*visiblewalls));
+        }
+
+        wall = &visiblewalls[numvisiblewalls++];
+        wall->seg = curline;
+        wall->start = start;
+        wall->stop = stop;
+        wall->doorclosed = doorclosed;
+        sub->numwalls++;
+
+        sub->x1 = MIN(sub->x1, start);
+        sub->x2 = MAX(sub->x2, stop);
+
+        // mark the segment as visible for automap
+        curline->linedef->flags |= ML_MAPPED;
+    }
+    else
+        R_StoreWallRange(start, stop);
+}
+
 //
 // R_ClearDrawSegs
 //
@@ -96,8 +165,8 @@ typedef struct
 #define MAXSEGS (SCREENWIDTH / 2 + 1)
 
 // newend is one past the last valid seg
-static cliprange_t      *newend;
-static cliprange_t      solidsegs[MAXSEGS];
+static THREADLOCAL cliprange_t  *newend;
+static THREADLOCAL cliprange_t  solidsegs[MAXSEGS];
 
 //
 // R_ClipSolidWallSegment
@@ -120,7 +189,7 @@ static void R_ClipSolidWallSegment(int first, int last)
         if (last < start->first - 1)
         {
             // Post is entirely visible (above start), so insert a new clippost.
-            R_StoreWallRange(first, last);
+            R_AddWallRange(first, last);
 
             // 1/11/98 killough: performance tuning using fast memmove
             memmove(start + 1, start, (++newend - start) * sizeof(*start));
@@ -130,7 +199,7 @@ static void R_ClipSolidWallSegment(int first, int last)
         }
 
         // There is a fragment above *start.
-        R_StoreWallRange(first, start->first - 1);
+        R_AddWallRange(first, start->first - 1);
 
         // Now adjust the clip size.
         start->first = first;
@@ -144,7 +213,7 @@ static void R_ClipSolidWallSegment(int first, int last)
     while (last >= (next + 1)->first - 1)
     {
         // There is a fragment between two posts.
-        R_StoreWallRange(next->last + 1, (next + 1)->first - 1);
+        R_AddWallRange(next->last + 1, (next + 1)->first - 1);
         next++;
 
         if (last <= next->last)
@@ -156,7 +225,7 @@ static void R_ClipSolidWallSegment(int first, int last)
     }
 
     // There is a fragment after *next.
-    R_StoreWallRange(next->last + 1, last);
+    R_AddWallRange(next->last + 1, last);
 
     // Adjust the clip size.
     start->last = last;
@@ -196,12 +265,12 @@ static void R_ClipPassWallSegment(int first, int last)
         if (last < start->first - 1)
         {
             // Post is entirely visible (above start).
-            R_StoreWallRange(first, last);
+            R_AddWallRange(first, last);
             return;
         }
 
         // There is a fragment above *start.
-        R_StoreWallRange(first, start->first - 1);
+        R_AddWallRange(first, start->first - 1);
     }
 
     // Bottom contained in start?
@@ -211,7 +280,7 @@ static void R_ClipPassWallSegment(int first, int last)
     while (last >= (start + 1)->first - 1)
     {
         // There is a fragment between two posts.
-        R_StoreWallRange(start->last + 1, (start + 1)->first - 1);
+        R_AddWallRange(start->last + 1, (start + 1)->first - 1);
         start++;
 
         if (last <= start->last)
@@ -219,7 +288,7 @@ static void R_ClipPassWallSegment(int first, int last)
     }
 
     // There is a fragment after *next.
-    R_StoreWallRange(start->last + 1, last);
+    R_AddWallRange(start->last + 1, last);
 }
 
 //
@@ -257,7 +326,7 @@ dboolean R_DoorClosed(void)
 }
 
 // [AM] Interpolate the passed sector, if prudent.
-void R_MaybeInterpolateSector(sector_t *sector)
+static void R_MaybeInterpolateSector(sector_t *sector)
 {
     if (vid_capfps != TICRATE
         // Only if we moved the sector last tic.
@@ -282,6 +351,30 @@ void R_MaybeInterpolateSector(sector_t *sector)
     }
 }
 
+//
+// R_InterpolateSectors
+// [BH] Interpolate every sector and apply the current to liquid sectors once,
+//  before any rendering starts, so the BSP pass never writes to sectors and
+//  each render strip sees the same heights and offsets.
+//
+void R_InterpolateSectors(void)
+{
+    int i;
+
+    for (i = 0; i < numsectors; i++)
+    {
+        sector_t    *sector = &sectors[i];
+
+        R_MaybeInterpolateSector(sector);
+
+        if (sector->isliquid && r_liquid_current && sector->heightsec == -1 && !freeze)
+        {
+            sector->floor_xoffs = animatedliquidxoffs;
+            sector->floor_yoffs = animatedliquidyoffs;
+        }
+    }
+}
+
 //
 // killough 3/7/98: Hack floor/ceiling heights for deep water etc.
 //
@@ -400,7 +493,7 @@ static void R_AddLine(seg_t *line)
     int                 x2;
     angle_t             angle1;
     angle_t             angle2;
-    static sector_t     tempsec;        // killough 3/8/98: ceiling/water hack
+    static THREADLOCAL sector_t tempsec;    // killough 3/8/98: ceiling/water hack
 
     curline = line;
 
@@ -453,11 +546,6 @@ static void R_AddLine(seg_t *line)
     if (!backsector)
         goto clipsolid;
 
-    // [AM] Interpolate sector movement before
-    //      running clipping tests. Frontsector
-    //      should already be interpolated.
-    R_MaybeInterpolateSector(backsector);
-
     // killough 3/8/98, 4/4/98: hack for invisible ceilings / deep water
     backsector = R_FakeFlat(backsector, &tempsec, NULL, NULL, true);
 
@@ -605,13 +693,43 @@ static dboolean R_CheckBBox(const fixed_t *bspcoord)
     return true;
 }
 
+//
+// R_RenderVisibleWalls
+// [BH] Draw the walls of a subsector found by R_FindVisibleSubsectors() that
+//  are in this render strip. They were clipped against the whole view, so each
+//  is stored with the same columns, scales and steps as if there was only one
+//  strip, and only R_RenderSegLoop() is limited to the columns in this strip.
+//
+static void R_RenderVisibleWalls(const visiblesubsector_t *visible)
+{
+    static THREADLOCAL sector_t tempsec;    // killough 3/8/98: ceiling/water hack
+    const visiblewall_t         *wall = &visiblewalls[visible->firstwall];
+    int                         count = visible->numwalls;
+
+    for (; count--; wall++)
+    {
+        if (wall->start > stripx2 || wall->stop < stripx1)
+            continue;
+
+        curline = wall->seg;
+        backsector = curline->backsector;
+
+        if (backsector)
+            backsector = R_FakeFlat(backsector, &tempsec, NULL, NULL, true);
+
+        doorclosed = wall->doorclosed;
+        R_StoreWallRange(wall->start, wall->stop);
+    }
+}
+
 //
 // R_Subsector
 // Determine floor/ceiling planes.
 // Add sprites of things in sector.
 // Draw one or more line segments.
+// [BH] If visible is given, only draw the walls R_FindVisibleSubsectors() found.
 //
-static void R_Subsector(int num)
+static void R_Subsector(int num, const visiblesubsector_t *visible)
 {
     subsector_t *sub = &subsectors[num];
     sector_t    tempsec;              // killough 3/7/98: deep water hack
@@ -622,33 +740,42 @@ static void R_Subsector(int num)
 
     frontsector = sub->sector;
 
-    // [AM] Interpolate sector movement. Usually only needed
-    //      when you're standing inside the sector.
-    R_MaybeInterpolateSector(frontsector);
-
     // killough 3/8/98, 4/4/98: Deep water / fake ceiling effect
     frontsector = R_FakeFlat(frontsector, &tempsec, &floorlightlevel, &ceilinglightlevel, false);
 
-    floorplane = (frontsector->interpfloorheight < viewz        // killough 3/7/98
-        || (frontsector->heightsec != -1
-        && sectors[frontsector->heightsec].ceilingpic == skyflatnum) ?
-        R_FindPlane(frontsector->interpfloorheight,
-            (frontsector->floorpic == skyflatnum                // killough 10/98
-                && (frontsector->sky & PL_SKYFLAT) ? frontsector->sky : frontsector->floorpic),
-            floorlightlevel,                                    // killough 3/16/98
-            frontsector->floor_xoffs,                           // killough 3/7/98
-            frontsector->floor_yoffs) : NULL);
-
-    ceilingplane = (frontsector->interpceilingheight > viewz
-        || frontsector->ceilingpic == skyflatnum
-        || (frontsector->heightsec != -1
-        && sectors[frontsector->heightsec].floorpic == skyflatnum) ?
-        R_FindPlane(frontsector->interpceilingheight,           // killough 3/8/98
-            (frontsector->ceilingpic == skyflatnum              // killough 10/98
-                && (frontsector->sky & PL_SKYFLAT) ? frontsector->sky : frontsector->ceilingpic),
-            ceilinglightlevel,                                  // killough 4/11/98
-            frontsector->ceiling_xoffs,                         // killough 3/7/98
-            frontsector->ceiling_yoffs) : NULL);
+    if (findingsubsectors)
+    {
+        visiblesubsector_t  *found = &visiblesubsectors[numvisiblesubsectors++];
+
+        found->num = num;
+        found->x1 = INT_MAX;
+        found->x2 = INT_MIN;
+        found->firstwall = numvisiblewalls;
+        found->numwalls = 0;
+    }
+    else
+    {
+        floorplane = (frontsector->interpfloorheight < viewz        // killough 3/7/98
+            || (frontsector->heightsec != -1
+            && sectors[frontsector->heightsec].ceilingpic == skyflatnum) ?
+            R_FindPlane(frontsector->interpfloorheight,
+                (frontsector->floorpic == skyflatnum                // killough 10/98
+                    && (frontsector->sky & PL_SKYFLAT) ? frontsector->sky : frontsector->floorpic),
+                floorlightlevel,                                    // killough 3/16/98
+                frontsector->floor_xoffs,                           // killough 3/7/98
+                frontsector->floor_yoffs) : NULL);
+
+        ceilingplane = (frontsector->interpceilingheight > viewz
+            || frontsector->ceilingpic == skyflatnum
+            || (frontsector->heightsec != -1
+            && sectors[frontsector->heightsec].floorpic == skyflatnum) ?
+            R_FindPlane(frontsector->interpceilingheight,           // killough 3/8/98
+                (frontsector->ceilingpic == skyflatnum              // killough 10/98
+                    && (frontsector->sky & PL_SKYFLAT) ? frontsector->sky : frontsector->ceilingpic),
+                ceilinglightlevel,                                  // killough 4/11/98
+                frontsector->ceiling_xoffs,                         // killough 3/7/98
+                frontsector->ceiling_yoffs) : NULL);
+    }
 
     // killough 9/18/98: Fix underwater slowdown, by passing real sector
     // instead of fake one. Improve sprite lighting by basing sprite
@@ -662,7 +789,7 @@ static void R_Subsector(int num)
     // Either you must pass the fake sector and handle validcount here, on the
     // real sector, or you must account for the lighting in some other way,
     // like passing it as an argument.
-    if (sub->sector->validcount != validcount)
+    if (!visible && sub->sector->validcount != validcount)
     {
         sub->sector->validcount = validcount;
         R_AddSprites(sub->sector, (frontsector->ceilingpic == skyflatnum
@@ -670,8 +797,16 @@ static void R_Subsector(int num)
             floorlightlevel));
     }
 
-    while (count--)
-        R_AddLine(line++);
+    // [BH] frontsector may be tempsec, so the walls are drawn before returning
+    if (visible)
+        R_RenderVisibleWalls(visible);
+    else
+        while (count--)
+            R_AddLine(line++);
+
+    // [BH] forget a subsector none of whose segs are visible
+    if (findingsubsectors && visiblesubsectors[numvisiblesubsectors - 1].x1 == INT_MAX)
+        numvisiblesubsectors--;
 }
 
 //
@@ -697,5 +832,46 @@ void R_RenderBSPNode(int bspnum)
 
         bspnum = bsp->children[side];
     }
-    R_Subsector(bspnum == -1 ? 0 : (bspnum & ~NF_SUBSECTOR));
+    R_Subsector(bspnum == -1 ? 0 : (bspnum & ~NF_SUBSECTOR), NULL);
+}
+
+//
+// R_FindVisibleSubsectors
+// [BH] Walk the BSP once for the whole view, adding sprites and marking lines on
+//  the automap as usual, but only noting which subsectors are visible and in
+//  which columns rather than drawing them. Every render strip then draws those
+//  subsectors with R_RenderVisibleSubsectors() instead of walking the BSP again.
+//
+void R_FindVisibleSubsectors(void)
+{
+    if (maxvisiblesubsectors < numsubsectors)
+    {
+        maxvisiblesubsectors = numsubsectors;
+        visiblesubsectors = Z_Realloc(visiblesubsectors,
+            maxvisiblesubsectors * sizeof(*visiblesubsectors));
+    }
+
+    numvisiblesubsectors = 0;
+    numvisiblewalls = 0;
+    findingsubsectors = true;
+    R_RenderBSPNode(numnodes - 1);
+    findingsubsectors = false;
+}
+
+//
+// R_RenderVisibleSubsectors
+// [BH] Draw the subsectors found by R_FindVisibleSubsectors() that are in this
+//  render strip, front to back, just as R_RenderBSPNode() would.
+//
+void R_RenderVisibleSubsectors(void)
+{
+    int i;
+
+    for (i = 0; i < numvisiblesubsectors; i++)
+    {
+        const visiblesubsector_t    *visible = &visiblesubsectors[i];
+
+        if (visible->x1 <= stripx2 && visible->x2 >= stripx1)
+            R_Subsector(visible->num, visible);
+    }
 }
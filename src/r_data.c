@@ -233,12 +233,171 @@ byte *R_GetTextureColumn(rpatch_t *texpatch, int col)
     return texpatch->columns[col].pixels;
 }
 
+// [BH] A texture as it's saved in the startup cache, followed by its patches
+typedef struct
+{
+    char                name[8];
+    int                 width;
+    int                 height;
+    int                 patchcount;
+} cachetexture_t;
+
+typedef struct
+{
+    int                 originx;
+    int                 originy;
+    int                 patch;
+    int                 mappatch;
+} cachepatch_t;
+
 //
-// R_InitTextures
-// Initializes the texture list
-//  with the textures from the world map.
+// R_LoadTextures
+// [BH] Loads the texture list from the startup cache. Returns false if it isn't there.
 //
-void R_InitTextures(void)
+static dboolean R_LoadTextures(uint64_t key)
+{
+    size_t      size;
+    byte        *data = W_LoadCache("textures", key, &size);
+    byte        *p = data;
+    byte        *end = data + size;
+    int         i, j;
+
+    if (!data)
+        return false;
+
+    if (size < sizeof(numtextures))
+    {
+        Z_Free(data);
+        return false;
+    }
+
+    memcpy(&numtextures, p, sizeof(numtextures));
+    p += sizeof(numtextures);
+
+    if (numtextures < 0 || (size_t)numtextures > size / sizeof(cachetexture_t))
+    {
+        Z_Free(data);
+        return false;
+    }
+
+    textures = Z_Calloc(numtextures, sizeof(*textures), PU_STATIC, NULL);
+    textureheight = Z_Malloc(numtextures * sizeof(*textureheight), PU_STATIC, NULL);
+
+    for (i = 0; i < numtextures; i++)
+    {
+        cachetexture_t  cachetexture;
+        texture_t       *texture;
+
+        if ((size_t)(end - p) < sizeof(cachetexture))
+            break;
+
+        memcpy(&cachetexture, p, sizeof(cachetexture));
+        p += sizeof(cachetexture);
+
+        if (cachetexture.patchcount < 0
+            || (size_t)(end - p) / sizeof(cachepatch_t) < (size_t)cachetexture.patchcount)
+            break;
+
+        texture = textures[i] = Z_Malloc(sizeof(texture_t) + sizeof(texpatch_t)
+            * (cachetexture.patchcount - 1), PU_STATIC, 0);
+
+        memcpy(texture->name, cachetexture.name, sizeof(texture->name));
+        texture->width = cachetexture.width;
+        texture->height = cachetexture.height;
+        texture->patchcount = cachetexture.patchcount;
+
+        for (j = 0; j < texture->patchcount; j++)
+        {
+            cachepatch_t    cachepatch;
+            texpatch_t      *patch = &texture->patches[j];
+
+            memcpy(&cachepatch, p, sizeof(cachepatch));
+            p += sizeof(cachepatch);
+
+            patch->originx = cachepatch.originx;
+            patch->originy = cachepatch.originy;
+            patch->patch = cachepatch.patch;
+            if (patch->patch == -1)
+                C_Warning("Patch %i is missing in the %.8s texture.", cachepatch.mappatch,
+                    texture->name);
+        }
+
+        for (j = 1; j * 2 <= texture->width; j <<= 1);
+        texture->widthmask = j - 1;
+        textureheight[i] = texture->height << FRACBITS;
+    }
+
+    Z_Free(data);
+
+    // a cache that doesn't hold every texture isn't used
+    if (i < numtextures || p != end)
+    {
+        for (j = 0; j < i; j++)
+            Z_Free(textures[j]);
+
+        Z_Free(textures);
+        Z_Free(textureheight);
+        return false;
+    }
+
+    return true;
+}
+
+//
+// R_SaveTextures
+// [BH] Saves the texture list in the startup cache.
+//
+static void R_SaveTextures(uint64_t key, const short *mappatches)
+{
+    size_t  size = sizeof(numtextures);
+    byte    *data;
+    byte    *p;
+    int     i, j;
+
+    for (i = 0; i < numtextures; i++)
+        size += sizeof(cachetexture_t) + textures[i]->patchcount * sizeof(cachepatch_t);
+
+    p = data = calloc(1, size);
+
+    memcpy(p, &numtextures, sizeof(numtextures));
+    p += sizeof(numtextures);
+
+    for (i = 0; i < numtextures; i++)
+    {
+        texture_t       *texture = textures[i];
+        cachetexture_t  cachetexture;
+
+        memset(&cachetexture, 0, sizeof(cachetexture));
+        memcpy(cachetexture.name, texture->name, sizeof(cachetexture.name));
+        cachetexture.width = texture->width;
+        cachetexture.height = texture->height;
+        cachetexture.patchcount = texture->patchcount;
+        memcpy(p, &cachetexture, sizeof(cachetexture));
+        p += sizeof(cachetexture);
+
+        for (j = 0; j < texture->patchcount; j++)
+        {
+            cachepatch_t    cachepatch;
+
+            cachepatch.originx = texture->patches[j].originx;
+            cachepatch.originy = texture->patches[j].originy;
+            cachepatch.patch = texture->patches[j].patch;
+            cachepatch.mappatch = *mappatches++;
+            memcpy(p, &cachepatch, sizeof(cachepatch));
+            p += sizeof(cachepatch);
+        }
+    }
+
+    W_SaveCache("textures", key, data, size);
+    free(data);
+}
+
+//
+// R_ReadTextures
+// Reads the texture list from the PNAMES and TEXTUREx lumps. Returns the index into
+//  PNAMES of every patch, in order, for R_SaveTextures().
+//
+static short *R_ReadTextures(void)
 {
     const maptexture_t  *mtexture;
     texture_t           *texture;
@@ -255,6 +414,9 @@ void R_InitTextures(void)
     int                 maxoff, maxoff2;
     int                 numtextures1, numtextures2;
     const int           *directory;
+    short               *mappatches = NULL;
+    int                 nummappatchrefs = 0;
+    int                 maxmappatchrefs = 0;
 
     // Load the patch names from pnames.lmp.
     name[8] = '\0';
@@ -333,11 +495,28 @@ void R_InitTextures(void)
         mpatch = mtexture->patches;
         patch = texture->patches;
 
+        if (nummappatchrefs + texture->patchcount > maxmappatchrefs)
+        {
+            short   *newmappatches;
+
+            maxmappatchrefs = MAX(maxmappatchrefs * 2, nummappatchrefs + texture->patchcount);
+            newmappatches = Z_Malloc(maxmappatchrefs * sizeof(*newmappatches), PU_STATIC, NULL);
+
+            if (mappatches)
+            {
+                memcpy(newmappatches, mappatches, nummappatchrefs * sizeof(*mappatches));
+                Z_Free(mappatches);
+            }
+
+            mappatches = newmappatches;
+        }
+
         for (j = 0; j < texture->patchcount; j++, mpatch++, patch++)
         {
             patch->originx = SHORT(mpatch->originx);
             patch->originy = SHORT(mpatch->originy);
             patch->patch = patchlookup[SHORT(mpatch->patch)];
+            mappatches[nummappatchrefs++] = SHORT(mpatch->patch);
             if (patch->patch == -1)
                 C_Warning("Patch %i is missing in the %.8s texture.", SHORT(mpatch->patch),
                     texture->name);     // killough 4/17/98
@@ -354,6 +533,30 @@ void R_InitTextures(void)
         if (maptex_lump[i] != -1)
             W_ReleaseLumpNum(maptex_lump[i]);
 
+    return mappatches;
+}
+
+//
+// R_InitTextures
+// Initializes the texture list
+//  with the textures from the world map.
+//
+void R_InitTextures(void)
+{
+    int         i, j;
+    uint64_t    key = W_HashWADs();
+
+    // [BH] The texture list is kept in the startup cache for the same WADs.
+    if (!R_LoadTextures(key))
+    {
+        short   *mappatches = R_ReadTextures();
+
+        R_SaveTextures(key, mappatches);
+
+        if (mappatches)
+            Z_Free(mappatches);
+    }
+
     // Create translation table for global animation.
     // killough 4/9/98: make column offsets 32-bit;
     // clean up malloc-ing to use sizeof
@@ -422,7 +625,11 @@ void R_InitFlats(void)
 //
 void R_InitSpriteLumps(void)
 {
-    int i;
+    int         i;
+    size_t      size;
+    size_t      cachesize;
+    uint64_t    key;
+    fixed_t     *metrics;
 
     firstspritelump = W_GetNumForName("S_START") + 1;
     lastspritelump = W_GetNumForName("S_END") - 1;
@@ -436,38 +643,77 @@ void R_InitSpriteLumps(void)
     newspriteoffset = Z_Malloc(numspritelumps * sizeof(*newspriteoffset), PU_STATIC, NULL);
     newspritetopoffset = Z_Malloc(numspritelumps * sizeof(*newspritetopoffset), PU_STATIC, NULL);
 
-    for (i = 0; i < numspritelumps; i++)
+    // [BH] Every sprite lump needs to be read to get these, so they're kept in the startup
+    //  cache for the same WADs.
+    size = numspritelumps * sizeof(*spritewidth);
+    key = W_HashWADs();
+
+    if ((metrics = W_LoadCache("sprites", key, &cachesize)) && cachesize == size * 4)
+    {
+        memcpy(spritewidth, metrics, size);
+        memcpy(spriteheight, metrics + numspritelumps, size);
+        memcpy(spriteoffset, metrics + numspritelumps * 2, size);
+        memcpy(spritetopoffset, metrics + numspritelumps * 3, size);
+        Z_Free(metrics);
+    }
+    else
+    {
+        if (metrics)
+            Z_Free(metrics);
+
+        for (i = 0; i < numspritelumps; i++)
+        {
+            patch_t *patch = W_CacheLumpNum(firstspritelump + i, PU_CACHE);
+
+            if (patch)
+            {
+                spritewidth[i] = SHORT(patch->width) << FRACBITS;
+                spriteheight[i] = SHORT(patch->height) << FRACBITS;
+                spriteoffset[i] = SHORT(patch->leftoffset) << FRACBITS;
+                spritetopoffset[i] = SHORT(patch->topoffset) << FRACBITS;
+            }
+            else
+            {
+                spritewidth[i] = 0;
+                spriteheight[i] = 0;
+                spriteoffset[i] = 0;
+                spritetopoffset[i] = 0;
+            }
+        }
+
+        metrics = malloc(size * 4);
+        memcpy(metrics, spritewidth, size);
+        memcpy(metrics + numspritelumps, spriteheight, size);
+        memcpy(metrics + numspritelumps * 2, spriteoffset, size);
+        memcpy(metrics + numspritelumps * 3, spritetopoffset, size);
+        W_SaveCache("sprites", key, metrics, size * 4);
+        free(metrics);
+    }
+
+    memcpy(newspriteoffset, spriteoffset, size);
+    memcpy(newspritetopoffset, spritetopoffset, size);
+
+    // [BH] override sprite offsets in WAD with those in sproffsets[] in info.c
+    if (r_fixspriteoffsets && !FREEDOOM && !hacx)
     {
-        patch_t *patch = W_CacheLumpNum(firstspritelump + i, PU_CACHE);
+        dboolean    *fixed = calloc(numspritelumps, sizeof(*fixed));
 
-        if (patch)
+        for (i = 0; *sproffsets[i].name; i++)
         {
-            spritewidth[i] = SHORT(patch->width) << FRACBITS;
-            spriteheight[i] = SHORT(patch->height) << FRACBITS;
-            spriteoffset[i] = newspriteoffset[i] = SHORT(patch->leftoffset) << FRACBITS;
-            spritetopoffset[i] = newspritetopoffset[i] = SHORT(patch->topoffset) << FRACBITS;
+            int j = W_CheckNumForSprite(sproffsets[i].name) - firstspritelump;
 
-            // [BH] override sprite offsets in WAD with those in sproffsets[] in info.c
-            if (r_fixspriteoffsets && !FREEDOOM && !hacx)
+            if (j >= 0 && j < numspritelumps && !fixed[j]
+                && spritewidth[j] == (SHORT(sproffsets[i].width) << FRACBITS)
+                && spriteheight[j] == (SHORT(sproffsets[i].height) << FRACBITS)
+                && ((!BTSX && !sprfix18) || sproffsets[i].sprfix18))
             {
-                int     j = 0;
-
-                while (*sproffsets[j].name)
-                {
-                    if (i == W_CheckNumForName(sproffsets[j].name) - firstspritelump
-                        && spritewidth[i] == (SHORT(sproffsets[j].width) << FRACBITS)
-                        && spriteheight[i] == (SHORT(sproffsets[j].height) << FRACBITS)
-                        && ((!BTSX && !sprfix18) || sproffsets[j].sprfix18))
-                    {
-                        newspriteoffset[i] = SHORT(sproffsets[j].x) << FRACBITS;
-                        newspritetopoffset[i] = SHORT(sproffsets[j].y) << FRACBITS;
-                        break;
-                    }
-
-                    j++;
-                }
+                newspriteoffset[j] = SHORT(sproffsets[i].x) << FRACBITS;
+                newspritetopoffset[j] = SHORT(sproffsets[i].y) << FRACBITS;
+                fixed[j] = true;
             }
         }
+
+        free(fixed);
     }
 
     // [BH] compatibility fixes
@@ -624,7 +870,7 @@ int R_FlatNumForName(char *name)
 {
     int  i;
 
-    i = W_RangeCheckNumForName(firstflat, lastflat, name);
+    i = W_CheckNumForFlat(name);
 
     if (i == -1)
     {
@@ -640,13 +886,9 @@ int R_FlatNumForName(char *name)
 //
 int R_CheckFlatNumForName(char *name)
 {
-    int i;
-
-    for (i = firstflat; i <= lastflat; i++)
-        if (!strncasecmp(lumpinfo[i]->name, name, 8))
-            return (i - firstflat);
+    int i = W_CheckNumForFlat(name);
 
-    return -1;
+    return (i == -1 ? -1 : i - firstflat);
 }
 
 //
@@ -727,14 +969,8 @@ void R_PrecacheLevel(void)
     //  name.
     hitlist[skytexture] = 1;
 
-    for (i = 0; i < numtextures; i++)
-        if (hitlist[i])
-        {
-            texture_t       *texture = textures[i];
-
-            for (j = 0; j < texture->patchcount; j++)
-                W_CacheLumpNum(texture->patches[j].patch, PU_CACHE);
-        }
+    // [BH] build their composites on another thread
+    R_PrecacheCompositePatches(hitlist);
 
     // Precache sprites.
     memset(hitlist, 0, NUMSPRITES);
@@ -118,7 +118,11 @@ typedef struct sector_s
     // list of mobjs in sector
     mobj_t              *thinglist;
 
-    bloodsplat_t        *splatlist;
+    // [BH] blood splats in sector
+    bloodsplat_t        *splats;
+    int                 firstsplat;
+    int                 numsplats;
+    int                 maxsplats;
 
     // thinker_t for reversible actions
     void                *floordata;             // jff 2/22/98 make thinkers on
@@ -132,9 +136,6 @@ typedef struct sector_s
     int                 linecount;
     struct line_s       **lines;                // [linecount] size
 
-    int                 cachedheight;
-    int                 scaleindex;
-
     // [AM] Previous position of floor and ceiling before
     //      think. Used to interpolate between positions.
     fixed_t             oldfloorheight;
@@ -42,6 +42,20 @@
 #include "v_video.h"
 #include "z_zone.h"
 
+#include "SDL_cpuinfo.h"
+
+#if defined(__i386__) || defined(__x86_64__) || defined(_M_IX86) || defined(_M_X64)
+#define SIMDSPANS
+
+#include <immintrin.h>
+
+#if defined(__GNUC__)
+#define TARGET(isa)     __attribute__((target(isa)))
+#else
+#define TARGET(isa)
+#endif
+#endif
+
 //
 // All drawing to the view buffer is accomplished in this file.
 // The other refresh files only know about coordinates,
@@ -152,20 +166,20 @@ byte megasphere[] =
 // R_DrawColumn
 // Source is the top of the column to scale.
 //
-lighttable_t    *dc_colormap;
-int             dc_x;
-int             dc_yl;
-int             dc_yh;
-fixed_t         dc_iscale;
-fixed_t         dc_texturemid;
-fixed_t         dc_texheight;
-fixed_t         dc_texturefrac;
-byte            *dc_blood;
-byte            *dc_colormask;
-int             dc_baseclip;
+THREADLOCAL lighttable_t    *dc_colormap;
+THREADLOCAL int             dc_x;
+THREADLOCAL int             dc_yl;
+THREADLOCAL int             dc_yh;
+THREADLOCAL fixed_t         dc_iscale;
+THREADLOCAL fixed_t         dc_texturemid;
+THREADLOCAL fixed_t         dc_texheight;
+THREADLOCAL fixed_t         dc_texturefrac;
+THREADLOCAL byte            *dc_blood;
+THREADLOCAL byte            *dc_colormask;
+THREADLOCAL int             dc_baseclip;
 
 // first pixel in a column (possibly virtual)
-byte            *dc_source;
+THREADLOCAL byte            *dc_source;
 
 extern int      skycolor;
 
@@ -1099,44 +1113,66 @@ void R_DrawTranslucentBlue25Column(void)
 //
 // Spectre/Invisibility.
 //
-extern int      fuzzpos;
-
 int             fuzzrange[3] = { -SCREENWIDTH, 0, SCREENWIDTH };
 
-#define FUZZ(a, b)      fuzzrange[rand() % (b - a + 1) + a]
+// [BH] changed once a frame, so the fuzz is the same for a pixel no matter
+//  which render strip draws it
+unsigned int    fuzzseed;
+
+#define FUZZ(a, b, h)   fuzzrange[(h) % ((b) - (a) + 1) + (a)]
 #define NOFUZZ          251
 
+//
+// R_FuzzHash
+// [BH] A random number for the given pixel of the view in this frame.
+//
+static unsigned int R_FuzzHash(int i)
+{
+    unsigned int    h = (unsigned int)i * 0x9E3779B1u + fuzzseed;
+
+    h ^= h >> 15;
+    h *= 0x2C1B3C6Du;
+    return (h ^ (h >> 12));
+}
+
 void R_DrawFuzzColumn(void)
 {
     byte        *dest;
     int         count = dc_yh - dc_yl;
+    int         i;
 
     if (count < 0)
         return;
 
-    dest = topleft0 + dc_yl * SCREENWIDTH + dc_x;
+    i = dc_yl * SCREENWIDTH + dc_x;
+    dest = topleft0 + i;
 
     if (count)
     {
+        unsigned int    h = R_FuzzHash(i);
+
         // top
         if (!dc_yl)
-            *dest = fullcolormap[6 * 256 + dest[(fuzztable[fuzzpos++] = FUZZ(1, 2))]];
-        else if (!(rand() % 4))
-            *dest = fullcolormap[12 * 256 + dest[(fuzztable[fuzzpos++] = FUZZ(0, 2))]];
+            *dest = fullcolormap[6 * 256 + dest[(fuzztable[i] = FUZZ(1, 2, h))]];
+        else if (!((h >> 8) & 3))
+            *dest = fullcolormap[12 * 256 + dest[(fuzztable[i] = FUZZ(0, 2, h))]];
         dest += SCREENWIDTH;
+        i += SCREENWIDTH;
 
         while (--count)
         {
             // middle
-            *dest = fullcolormap[6 * 256 + dest[(fuzztable[fuzzpos++] = FUZZ(0, 2))]];
+            *dest = fullcolormap[6 * 256 + dest[(fuzztable[i] = FUZZ(0, 2, R_FuzzHash(i)))]];
             dest += SCREENWIDTH;
+            i += SCREENWIDTH;
         }
 
         // bottom
+        h = R_FuzzHash(i);
         if (dc_yh == viewheight - 1)
-            *dest = fullcolormap[5 * 256 + dest[(fuzztable[fuzzpos] = FUZZ(0, 1))]];
-        else if (dc_baseclip == -1 && !(rand() % 4))
-            *dest = fullcolormap[14 * 256 + dest[(fuzztable[fuzzpos] = FUZZ(0, 1))]];
+            *dest = fullcolormap[5 * 256 + dest[(fuzztable[i] = FUZZ(0, 1, h))]];
+        else if (dc_baseclip == -1 && !((h >> 8) & 3))
+            *dest = fullcolormap[14 * 256 + dest[(fuzztable[i] = FUZZ(0, 1, h))]];
     }
 }
 
@@ -1144,35 +1180,33 @@ void R_DrawPausedFuzzColumn(void)
 {
     byte        *dest;
     int         count = dc_yh - dc_yl;
+    int         i;
 
     if (count < 0)
         return;
 
-    dest = topleft0 + dc_yl * SCREENWIDTH + dc_x;
+    i = dc_yl * SCREENWIDTH + dc_x;
+    dest = topleft0 + i;
 
     if (count)
     {
         // top
         if (!dc_yl)
-        {
-            *dest = fullcolormap[6 * 256 + dest[fuzztable[fuzzpos++]]];
-            if (fuzzpos == SCREENWIDTH * SCREENHEIGHT)
-                fuzzpos = 0;
-        }
+            *dest = fullcolormap[6 * 256 + dest[fuzztable[i]]];
         dest += SCREENWIDTH;
+        i += SCREENWIDTH;
 
         while (--count)
         {
             // middle
-            *dest = fullcolormap[6 * 256 + dest[fuzztable[fuzzpos++]]];
-            if (fuzzpos == SCREENWIDTH * SCREENHEIGHT)
-                fuzzpos = 0;
+            *dest = fullcolormap[6 * 256 + dest[fuzztable[i]]];
             dest += SCREENWIDTH;
+            i += SCREENWIDTH;
         }
 
         // bottom
         if (dc_yh == viewheight - 1)
-            *dest = fullcolormap[5 * 256 + dest[fuzztable[fuzzpos]]];
+            *dest = fullcolormap[5 * 256 + dest[fuzztable[i]]];
     }
 }
 
@@ -1190,35 +1224,36 @@ void R_DrawFuzzColumns(void)
 
             if (*src != NOFUZZ)
             {
-                byte    *dest = screens[0] + i;
+                byte            *dest = screens[0] + i;
+                unsigned int    r = R_FuzzHash(i);
 
                 if (!y || *(src - SCREENWIDTH) == NOFUZZ)
                 {
                     // top
-                    if (!(rand() % 4))
-                        *dest = fullcolormap[12 * 256 + dest[(fuzztable[i] = FUZZ(0, 2))]];
+                    if (!((r >> 8) & 3))
+                        *dest = fullcolormap[12 * 256 + dest[(fuzztable[i] = FUZZ(0, 2, r))]];
                 }
                 else if (y == h - SCREENWIDTH)
                 {
                     // bottom of view
-                    *dest = fullcolormap[5 * 256 + dest[(fuzztable[i] = FUZZ(0, 1))]];
+                    *dest = fullcolormap[5 * 256 + dest[(fuzztable[i] = FUZZ(0, 1, r))]];
                 }
                 else if (*(src + SCREENWIDTH) == NOFUZZ)
                 {
                     // bottom of post
-                    if (!(rand() % 4))
-                        *dest = fullcolormap[12 * 256 + dest[(fuzztable[i] = FUZZ(0, 2))]];
+                    if (!((r >> 8) & 3))
+                        *dest = fullcolormap[12 * 256 + dest[(fuzztable[i] = FUZZ(0, 2, r))]];
                 }
                 else
                 {
                     // middle
                     if (*(src - 1) == NOFUZZ || *(src + 1) == NOFUZZ)
                     {
-                        if (!(rand() % 4))
-                            *dest = fullcolormap[12 * 256 + dest[(fuzztable[i] = FUZZ(0, 2))]];
+                        if (!((r >> 8) & 3))
+                            *dest = fullcolormap[12 * 256 + dest[(fuzztable[i] = FUZZ(0, 2, r))]];
                     }
                     else
-                        *dest = fullcolormap[6 * 256 + dest[(fuzztable[i] = FUZZ(0, 2))]];
+                        *dest = fullcolormap[6 * 256 + dest[(fuzztable[i] = FUZZ(0, 2, r))]];
                 }
             }
         }
@@ -1278,7 +1313,7 @@ void R_DrawPausedFuzzColumns(void)
 //  of the BaronOfHell, the HellKnight, uses
 //  identical sprites, kinda brightened up.
 //
-byte    *dc_translation;
+THREADLOCAL byte            *dc_translation;
 byte    *translationtables;
 
 void R_DrawTranslatedColumn(void)
@@ -1340,19 +1375,19 @@ void R_InitTranslationTables(void)
 // In consequence, flats are not stored by column (like walls),
 //  and the inner loop has to step in texture space u and v.
 //
-int             ds_y;
-int             ds_x1;
-int             ds_x2;
+THREADLOCAL int             ds_y;
+THREADLOCAL int             ds_x1;
+THREADLOCAL int             ds_x2;
 
-lighttable_t    *ds_colormap;
+THREADLOCAL lighttable_t    *ds_colormap;
 
-fixed_t         ds_xfrac;
-fixed_t         ds_yfrac;
-fixed_t         ds_xstep;
-fixed_t         ds_ystep;
+THREADLOCAL fixed_t         ds_xfrac;
+THREADLOCAL fixed_t         ds_yfrac;
+THREADLOCAL fixed_t         ds_xstep;
+THREADLOCAL fixed_t         ds_ystep;
 
 // start of a 64*64 tile image
-byte            *ds_source;
+THREADLOCAL byte            *ds_source;
 
 //
 // Draws the actual span.
@@ -1422,16 +1457,234 @@ void R_DrawSpan(void)
     }
 }
 
-void R_DrawColorSpan(void)
+#if defined(SIMDSPANS)
+//
+// R_DrawSpanSSE2
+// [BH] Work out the texel offsets of 8 pixels at a time. There's no way to
+//  gather single bytes, so the flat and colormap are still read one pixel at
+//  a time. Fractions wrap exactly as they do in R_DrawSpan().
+//
+TARGET("sse2") static void R_DrawSpanSSE2(void)
 {
     unsigned int        count = ds_x2 - ds_x1 + 1;
     byte                *dest = topleft0 + ds_y * SCREENWIDTH + ds_x1;
-    byte                color = ds_colormap[NOTEXTURECOLOR];
+    unsigned int        xfrac = ds_xfrac;
+    unsigned int        yfrac = ds_yfrac;
+    const unsigned int  xstep = ds_xstep;
+    const unsigned int  ystep = ds_ystep;
+    const byte          *source = ds_source;
+    const lighttable_t  *colormap = ds_colormap;
 
-    while (--count)
-        *dest++ = color;
+    if (count >= 8)
+    {
+        __m128i         x = _mm_setr_epi32(xfrac, xfrac + xstep, xfrac + xstep * 2, xfrac + xstep * 3);
+        __m128i         y = _mm_setr_epi32(yfrac, yfrac + ystep, yfrac + ystep * 2, yfrac + ystep * 3);
+        const __m128i   xstep4 = _mm_set1_epi32(xstep * 4);
+        const __m128i   ystep4 = _mm_set1_epi32(ystep * 4);
+        const __m128i   xmask = _mm_set1_epi32(63);
+        const __m128i   ymask = _mm_set1_epi32(4032);
+
+        do
+        {
+            __m128i     i0 = _mm_or_si128(_mm_and_si128(_mm_srli_epi32(x, 16), xmask),
+                            _mm_and_si128(_mm_srli_epi32(y, 10), ymask));
+            __m128i     i1;
+
+            x = _mm_add_epi32(x, xstep4);
+            y = _mm_add_epi32(y, ystep4);
+            i1 = _mm_or_si128(_mm_and_si128(_mm_srli_epi32(x, 16), xmask),
+                _mm_and_si128(_mm_srli_epi32(y, 10), ymask));
+            x = _mm_add_epi32(x, xstep4);
+            y = _mm_add_epi32(y, ystep4);
+
+            i0 = _mm_packs_epi32(i0, i1);
+
+            dest[0] = colormap[source[_mm_extract_epi16(i0, 0)]];
+            dest[1] = colormap[source[_mm_extract_epi16(i0, 1)]];
+            dest[2] = colormap[source[_mm_extract_epi16(i0, 2)]];
+            dest[3] = colormap[source[_mm_extract_epi16(i0, 3)]];
+            dest[4] = colormap[source[_mm_extract_epi16(i0, 4)]];
+            dest[5] = colormap[source[_mm_extract_epi16(i0, 5)]];
+            dest[6] = colormap[source[_mm_extract_epi16(i0, 6)]];
+            dest[7] = colormap[source[_mm_extract_epi16(i0, 7)]];
+            dest += 8;
+            count -= 8;
+        } while (count >= 8);
 
-    *dest = color;
+        xfrac = _mm_cvtsi128_si32(x);
+        yfrac = _mm_cvtsi128_si32(y);
+    }
+
+    while (count--)
+    {
+        *dest++ = colormap[source[((xfrac >> 16) & 63) | ((yfrac >> 10) & 4032)]];
+        xfrac += xstep;
+        yfrac += ystep;
+    }
+}
+
+//
+// R_DrawSpanAVX2
+// [BH] As above, but 16 pixels at a time, with the texels and then their colors
+//  fetched by gathers. A gather can only fetch dwords, so each byte is read as
+//  part of the aligned dword it's in and shifted down. An aligned dword never
+//  crosses a page, so this never reads memory that isn't there.
+//
+TARGET("avx2") static __m256i R_GatherBytesAVX2(const byte *base, __m256i index)
+{
+    const int       *dwords = (const int *)((uintptr_t)base & ~(uintptr_t)3);
+    const __m256i   offset = _mm256_add_epi32(index, _mm256_set1_epi32((int)((uintptr_t)base & 3)));
+    const __m256i   shift = _mm256_slli_epi32(_mm256_and_si256(offset, _mm256_set1_epi32(3)), 3);
+
+    return _mm256_and_si256(_mm256_srlv_epi32(_mm256_i32gather_epi32(dwords,
+        _mm256_srli_epi32(offset, 2), 4), shift), _mm256_set1_epi32(0xFF));
+}
+
+TARGET("avx2") static void R_DrawSpanAVX2(void)
+{
+    unsigned int        count = ds_x2 - ds_x1 + 1;
+    byte                *dest = topleft0 + ds_y * SCREENWIDTH + ds_x1;
+    unsigned int        xfrac = ds_xfrac;
+    unsigned int        yfrac = ds_yfrac;
+    const unsigned int  xstep = ds_xstep;
+    const unsigned int  ystep = ds_ystep;
+    const byte          *source = ds_source;
+    const lighttable_t  *colormap = ds_colormap;
+
+    if (count >= 16)
+    {
+        __m256i         x = _mm256_add_epi32(_mm256_set1_epi32(xfrac),
+                            _mm256_mullo_epi32(_mm256_set1_epi32(xstep), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)));
+        __m256i         y = _mm256_add_epi32(_mm256_set1_epi32(yfrac),
+                            _mm256_mullo_epi32(_mm256_set1_epi32(ystep), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)));
+        const __m256i   xstep8 = _mm256_set1_epi32(xstep * 8);
+        const __m256i   ystep8 = _mm256_set1_epi32(ystep * 8);
+        const __m256i   xmask = _mm256_set1_epi32(63);
+        const __m256i   ymask = _mm256_set1_epi32(4032);
+
+        do
+        {
+            __m256i     c0 = _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi32(x, 16), xmask),
+                            _mm256_and_si256(_mm256_srli_epi32(y, 10), ymask));
+            __m256i     c1;
+            __m256i     c;
+
+            x = _mm256_add_epi32(x, xstep8);
+            y = _mm256_add_epi32(y, ystep8);
+            c1 = _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi32(x, 16), xmask),
+                _mm256_and_si256(_mm256_srli_epi32(y, 10), ymask));
+            x = _mm256_add_epi32(x, xstep8);
+            y = _mm256_add_epi32(y, ystep8);
+
+            c0 = R_GatherBytesAVX2(colormap, R_GatherBytesAVX2(source, c0));
+            c1 = R_GatherBytesAVX2(colormap, R_GatherBytesAVX2(source, c1));
+
+            // pack the 16 colors into 16 bytes in order
+            c = _mm256_permute4x64_epi64(_mm256_packus_epi32(c0, c1), 0xD8);
+            _mm_storeu_si128((__m128i *)dest,
+                _mm_packus_epi16(_mm256_castsi256_si128(c), _mm256_extracti128_si256(c, 1)));
+
+            dest += 16;
+            count -= 16;
+        } while (count >= 16);
+
+        xfrac = _mm_cvtsi128_si32(_mm256_castsi256_si128(x));
+        yfrac = _mm_cvtsi128_si32(_mm256_castsi256_si128(y));
+    }
+
+    while (count--)
+    {
+        *dest++ = colormap[source[((xfrac >> 16) & 63) | ((yfrac >> 10) & 4032)]];
+        xfrac += xstep;
+        yfrac += ystep;
+    }
+}
+
+//
+// R_SpanRandom
+// [BH] An LCG, so the same spans are checked every time.
+//
+static unsigned int R_SpanRandom(unsigned int *seed)
+{
+    return (*seed = *seed * 1103515245 + 12345);
+}
+
+//
+// R_CheckSpanFunction
+// [BH] Draw the same random spans with the given function and R_DrawSpan(), and
+//  return true only if every pixel they draw is the same.
+//
+static dboolean R_CheckSpanFunction(void (*func)(void))
+{
+    byte            *buffer = malloc(SCREENWIDTH * 2 + 4096 + 256);
+    byte            *topleft = topleft0;
+    unsigned int    seed = 1;
+    dboolean        result = true;
+    int             i;
+
+    if (!buffer)
+        return false;
+
+    for (i = 0; i < 4096 + 256; i++)
+        buffer[SCREENWIDTH * 2 + i] = R_SpanRandom(&seed) >> 24;
+
+    ds_source = buffer + SCREENWIDTH * 2;
+    ds_colormap = ds_source + 4096;
+    ds_y = 0;
+
+    for (i = 0; i < 10000 && result; i++)
+    {
+        ds_x1 = (R_SpanRandom(&seed) >> 8) % SCREENWIDTH;
+        ds_x2 = ds_x1 + (R_SpanRandom(&seed) >> 8) % (SCREENWIDTH - ds_x1);
+        ds_xfrac = R_SpanRandom(&seed);
+        ds_yfrac = R_SpanRandom(&seed);
+        ds_xstep = (int)R_SpanRandom(&seed) >> (i & 15);
+        ds_ystep = (int)R_SpanRandom(&seed) >> ((i >> 4) & 15);
+
+        memset(buffer, 0, SCREENWIDTH * 2);
+        topleft0 = buffer;
+        R_DrawSpan();
+        topleft0 = buffer + SCREENWIDTH;
+        func();
+        result = !memcmp(buffer, buffer + SCREENWIDTH, SCREENWIDTH);
+    }
+
+    topleft0 = topleft;
+    free(buffer);
+    return result;
+}
+#endif
+
+void R_DrawColorSpan(void)
+{
+    memset(topleft0 + ds_y * SCREENWIDTH + ds_x1, ds_colormap[NOTEXTURECOLOR], ds_x2 - ds_x1 + 1);
+}
+
+//
+// R_InitSpanFunction
+// [BH] Use the fastest version of R_DrawSpan() the CPU supports.
+//
+void R_InitSpanFunction(void)
+{
+#if defined(SIMDSPANS)
+    static void (*simdspanfunc)(void);
+    static dboolean checked;
+
+    // [BH] only use a version that draws exactly what R_DrawSpan() does
+    if (!checked)
+    {
+        checked = true;
+
+        if (SDL_HasAVX2() && R_CheckSpanFunction(R_DrawSpanAVX2))
+            simdspanfunc = R_DrawSpanAVX2;
+        else if (SDL_HasSSE2() && R_CheckSpanFunction(R_DrawSpanSSE2))
+            simdspanfunc = R_DrawSpanSSE2;
+    }
+
+    spanfunc = (simdspanfunc ? simdspanfunc : R_DrawSpan);
+#else
+    spanfunc = R_DrawSpan;
+#endif
 }
 
 //
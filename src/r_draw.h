@@ -46,20 +46,20 @@
 
 #define NOTEXTURECOLOR  80
 
-extern lighttable_t     *dc_colormap;
-extern int              dc_x;
-extern int              dc_yl;
-extern int              dc_yh;
-extern fixed_t          dc_iscale;
-extern fixed_t          dc_texturemid;
-extern fixed_t          dc_texheight;
-extern fixed_t          dc_texturefrac;
-extern byte             *dc_blood;
-extern byte             *dc_colormask;
-extern int              dc_baseclip;
+extern THREADLOCAL lighttable_t *dc_colormap;
+extern THREADLOCAL int          dc_x;
+extern THREADLOCAL int          dc_yl;
+extern THREADLOCAL int          dc_yh;
+extern THREADLOCAL fixed_t      dc_iscale;
+extern THREADLOCAL fixed_t      dc_texturemid;
+extern THREADLOCAL fixed_t      dc_texheight;
+extern THREADLOCAL fixed_t      dc_texturefrac;
+extern THREADLOCAL byte         *dc_blood;
+extern THREADLOCAL byte         *dc_colormask;
+extern THREADLOCAL int          dc_baseclip;
 
 // first pixel in a column
-extern byte             *dc_source;
+extern THREADLOCAL byte         *dc_source;
 
 extern byte             *tinttab;
 extern byte             *tinttab25;
@@ -116,6 +116,8 @@ void R_DrawMegaSphereColumn(void);
 void R_DrawSolidMegaSphereColumn(void);
 
 // The Spectre/Invisibility effect.
+extern unsigned int     fuzzseed;
+
 void R_DrawFuzzColumn(void);
 void R_DrawPausedFuzzColumn(void);
 void R_DrawFuzzColumns(void);
@@ -128,27 +130,28 @@ void R_DrawTranslatedColumn(void);
 
 void R_VideoErase(unsigned int ofs, int count);
 
-extern int              ds_y;
-extern int              ds_x1;
-extern int              ds_x2;
+extern THREADLOCAL int          ds_y;
+extern THREADLOCAL int          ds_x1;
+extern THREADLOCAL int          ds_x2;
 
-extern lighttable_t     *ds_colormap;
+extern THREADLOCAL lighttable_t *ds_colormap;
 
-extern fixed_t          ds_xfrac;
-extern fixed_t          ds_yfrac;
-extern fixed_t          ds_xstep;
-extern fixed_t          ds_ystep;
+extern THREADLOCAL fixed_t      ds_xfrac;
+extern THREADLOCAL fixed_t      ds_yfrac;
+extern THREADLOCAL fixed_t      ds_xstep;
+extern THREADLOCAL fixed_t      ds_ystep;
 
 // start of a 64*64 tile image
-extern byte             *ds_source;
+extern THREADLOCAL byte         *ds_source;
 
 extern byte             *translationtables;
-extern byte             *dc_translation;
+extern THREADLOCAL byte         *dc_translation;
 
 // Span blitting for rows, floor/ceiling.
 // No Spectre effect needed.
 void R_DrawSpan(void);
 void R_DrawColorSpan(void);
+void R_InitSpanFunction(void);
 
 void R_InitBuffer(int width, int height);
 
@@ -44,6 +44,8 @@
 #include "r_sky.h"
 #include "v_video.h"
 
+#include "SDL.h"
+
 // Fineangles in the SCREENWIDTH wide window.
 #define FIELDOFVIEW     2048
 
@@ -51,7 +53,10 @@
 int                     validcount = 1;
 
 lighttable_t            *fixedcolormap;
-extern lighttable_t     **walllights;
+extern THREADLOCAL lighttable_t **walllights;
+
+// killough 3/20/98: localize scalelightfixed (readability/optimization)
+static lighttable_t     *scalelightfixed[MAXLIGHTSCALE];
 
 int                     centerx;
 int                     centery;
@@ -75,6 +80,27 @@ player_t                *viewplayer;
 //      range of [0.0, 1.0). Used for interpolation.
 fixed_t                 fractionaltic;
 
+THREADLOCAL void        (*colfunc)(void);
+
+THREADLOCAL int         stripx1;
+THREADLOCAL int         stripx2;
+
+THREADLOCAL uint64_t    renderphasetime[NUMRENDERPHASES];
+
+typedef struct
+{
+    SDL_Thread          *thread;
+    SDL_sem             *start;
+    SDL_sem             *done;
+    int                 x1;
+    int                 x2;
+} renderstrip_t;
+
+static renderstrip_t    renderstrips[r_strips_max - 1];
+static int              numrenderstrips;
+static SDL_mutex        *rendercachemutex;
+static dboolean         renderingstrips;
+
 //
 // precalculated math tables
 //
@@ -113,10 +139,12 @@ dboolean                drawbloodsplats;
 dboolean                r_dither = r_dither_default;
 dboolean                r_homindicator = r_homindicator_default;
 dboolean                r_shake_barrels = r_shake_barrels_default;
+int                     r_strips = r_strips_default;
 dboolean                r_textures = r_textures_default;
 dboolean                r_translucency = r_translucency_default;
 
 extern dboolean         canmodify;
+extern dboolean         inhelpscreens;
 extern int              explosiontics;
 extern int              skycolor;
 extern dboolean         transferredsky;
@@ -505,7 +533,7 @@ void R_InitColumnFunctions(void)
         else
             skycolfunc = (canmodify && !transferredsky && (gamemode != commercial || gamemap < 21) ?
                 R_DrawFlippedSkyColumn : R_DrawSkyColumn);
-        spanfunc = R_DrawSpan;
+        R_InitSpanFunction();
 
         if (r_translucency)
         {
@@ -674,8 +702,10 @@ void R_SetupFrame(player_t *player)
     // [AM] Interpolate the player camera if the feature is enabled.
 
     // Figure out how far into the current tic we're in as a fixed_t
+    // [BH] to the microsecond. I_GetTime() counts tics from the same clock as
+    //  I_GetTimeUS(), so this is always how far into the tic it's counting.
     if (vid_capfps != TICRATE)
-        fractionaltic = I_GetTimeMS() * TICRATE % 1000 * FRACUNIT / 1000;
+        fractionaltic = (fixed_t)(I_GetTimeUS() * TICRATE % 1000000 * FRACUNIT / 1000000);
 
     if (vid_capfps != TICRATE
         // Don't interpolate on the first tic of a level, otherwise
@@ -701,6 +731,9 @@ void R_SetupFrame(player_t *player)
         viewangle = mo->angle;
     }
 
+    R_InterpolateSectors();
+    R_UpdateDistortedFlats();
+
     if (explosiontics && !consoleactive && !menuactive && !paused)
     {
         viewx += M_RandomInt(-2, 2) * FRACUNIT;
@@ -733,9 +766,7 @@ void R_SetupFrame(player_t *player)
 
     if (player->fixedcolormap)
     {
-        // killough 3/20/98: localize scalelightfixed (readability/optimization)
-        static lighttable_t     *scalelightfixed[MAXLIGHTSCALE];
-        int                     i;
+        int     i;
 
         // killough 3/20/98: use fullcolormap
         fixedcolormap = fullcolormap + player->fixedcolormap * 256 * sizeof(lighttable_t);
@@ -748,14 +779,161 @@ void R_SetupFrame(player_t *player)
     else
         fixedcolormap = 0;
 
+    stripx1 = 0;
+    stripx2 = viewwidth - 1;
+
+    fuzzseed++;
     validcount++;
 }
 
+//
+// R_LockRenderCache
+// [BH] Z_Malloc(), Z_ChangeTag() and friends aren't thread-safe, so any lump
+//  or composite cached while render strips are running is done one at a time.
+//
+void R_LockRenderCache(void)
+{
+    if (renderingstrips)
+        SDL_LockMutex(rendercachemutex);
+}
+
+void R_UnlockRenderCache(void)
+{
+    if (renderingstrips)
+        SDL_UnlockMutex(rendercachemutex);
+}
+
+//
+// R_TimeRenderPhase
+// [BH] Add the time since start to a phase, and return the time now.
+//
+static uint64_t R_TimeRenderPhase(int phase, uint64_t start)
+{
+    uint64_t    now = I_GetTimeUS();
+
+    renderphasetime[phase] += now - start;
+    return now;
+}
+
+//
+// R_RenderStrip
+// [BH] Render the columns from x1 to x2 of the player's view. The BSP has
+//  already been walked once for the whole view by R_FindVisibleSubsectors(),
+//  so only the subsectors and vissprites it found in these columns are drawn.
+//
+static void R_RenderStrip(int x1, int x2)
+{
+    uint64_t    time;
+
+    stripx1 = x1;
+    stripx2 = x2;
+
+    if (fixedcolormap)
+        walllights = scalelightfixed;
+
+    R_ClearClipSegs();
+    R_ClearDrawSegs();
+    R_ClearPlanes();
+
+    time = I_GetTimeUS();
+    R_RenderVisibleSubsectors();
+    time = R_TimeRenderPhase(rp_bsp, time);
+    R_DrawPlanes();
+    time = R_TimeRenderPhase(rp_planes, time);
+    R_DrawMasked();
+    R_TimeRenderPhase(rp_masked, time);
+}
+
+static int SDLCALL R_RenderStripThread(void *data)
+{
+    renderstrip_t   *strip = data;
+
+    while (true)
+    {
+        SDL_SemWait(strip->start);
+        R_RenderStrip(strip->x1, strip->x2);
+        SDL_SemPost(strip->done);
+    }
+
+    return 0;
+}
+
+//
+// R_InitRenderStrips
+// [BH] Start enough threads to render the given number of strips, and return
+//  how many strips can actually be rendered.
+//
+static int R_InitRenderStrips(int strips)
+{
+    if (!rendercachemutex && !(rendercachemutex = SDL_CreateMutex()))
+        return 1;
+
+    while (numrenderstrips < strips - 1)
+    {
+        renderstrip_t   *strip = &renderstrips[numrenderstrips];
+
+        strip->start = SDL_CreateSemaphore(0);
+        strip->done = SDL_CreateSemaphore(0);
+
+        if (!strip->start || !strip->done
+            || !(strip->thread = SDL_CreateThread(R_RenderStripThread, "R_RenderStrip", strip)))
+        {
+            if (strip->start)
+                SDL_DestroySemaphore(strip->start);
+
+            if (strip->done)
+                SDL_DestroySemaphore(strip->done);
+
+            break;
+        }
+
+        numrenderstrips++;
+    }
+
+    return MIN(strips, numrenderstrips + 1);
+}
+
+//
+// R_RenderStrips
+// [BH] Split the player's view into vertical strips and render them in
+//  parallel. The main thread renders the leftmost strip itself.
+//
+static void R_RenderStrips(int strips)
+{
+    int         i;
+    uint64_t    time = I_GetTimeUS();
+
+    R_FindVisibleSubsectors();
+    R_TimeRenderPhase(rp_bsp, time);
+
+    renderingstrips = true;
+
+    for (i = 1; i < strips; i++)
+    {
+        renderstrip_t   *strip = &renderstrips[i - 1];
+
+        strip->x1 = viewwidth * i / strips;
+        strip->x2 = viewwidth * (i + 1) / strips - 1;
+        SDL_SemPost(strip->start);
+    }
+
+    R_RenderStrip(0, viewwidth / strips - 1);
+
+    for (i = 1; i < strips; i++)
+        SDL_SemWait(renderstrips[i - 1].done);
+
+    renderingstrips = false;
+
+    stripx1 = 0;
+    stripx2 = viewwidth - 1;
+}
+
 //
 // R_RenderPlayerView
 //
 void R_RenderPlayerView(player_t *player)
 {
+    R_FinishPrecache(false);
     R_SetupFrame(player);
 
     // Clear buffers.
@@ -777,23 +955,41 @@ void R_RenderPlayerView(player_t *player)
     }
     else
     {
+        int strips;
+
         if ((player->cheats & CF_NOCLIP) || freeze)
             V_FillRect(0, viewwindowx, viewwindowy, viewwidth, viewheight, 0);
         else if (r_homindicator)
             V_FillRect(0, viewwindowx, viewwindowy, viewwidth, viewheight,
                 ((gametic % 20) < 9 && !consoleactive && !menuactive && !paused ? 176 : 0));
 
-        // Make displayed player invisible locally
-        R_RenderBSPNode(numnodes - 1);  // head node is the last node output
+        if (r_strips > 1 && (strips = R_InitRenderStrips(r_strips)) > 1)
+            R_RenderStrips(strips);
+        else
+        {
+            uint64_t    time = I_GetTimeUS();
 
-        NetUpdate();
+            // Make displayed player invisible locally
+            R_RenderBSPNode(numnodes - 1);  // head node is the last node output
+            R_TimeRenderPhase(rp_bsp, time);
 
-        R_DrawPlanes();
+            NetUpdate();
 
-        NetUpdate();
+            time = I_GetTimeUS();
+            R_DrawPlanes();
+            R_TimeRenderPhase(rp_planes, time);
+
+            NetUpdate();
 
-        R_DrawMasked();
+            time = I_GetTimeUS();
+            R_DrawMasked();
+            R_TimeRenderPhase(rp_masked, time);
+        }
 
         NetUpdate();
+
+        // draw the psprites on top of everything
+        if (r_playersprites && !inhelpscreens)
+            R_DrawPlayerSprites();
     }
 }
@@ -101,11 +101,28 @@ extern lighttable_t     *fixedcolormap;
 //      range of [0.0, 1.0). Used for interpolation.
 extern fixed_t          fractionaltic;
 
+// [BH] Columns of the view the current render strip is allowed to draw to.
+//  Each strip walks the whole BSP but only draws between these.
+extern THREADLOCAL int  stripx1;
+extern THREADLOCAL int  stripx2;
+
+// [BH] Time spent in each phase of rendering the player's view, in
+//  performance counter ticks. Only the leftmost render strip is timed.
+enum
+{
+    rp_bsp,
+    rp_planes,
+    rp_masked,
+    NUMRENDERPHASES
+};
+
+extern THREADLOCAL uint64_t renderphasetime[NUMRENDERPHASES];
+
 //
 // Function pointers to switch refresh/drawing functions.
 // Used to select shadow mode etc.
 //
-void (*colfunc)(void);
+extern THREADLOCAL void (*colfunc)(void);
 void (*wallcolfunc)(void);
 void (*fbwallcolfunc)(void);
 void (*transcolfunc)(void);
@@ -163,4 +180,8 @@ void R_Init(void);
 void R_SetViewSize(int blocks);
 void R_InitColumnFunctions(void);
 
+// Serialize zone and cache access from render strips.
+void R_LockRenderCache(void);
+void R_UnlockRenderCache(void);
+
 #endif
@@ -66,12 +66,17 @@
 **---------------------------------------------------------------------------
 */
 
+#include "c_console.h"
 #include "i_swap.h"
 #include "i_system.h"
+#include "i_timer.h"
+#include "m_misc.h"
 #include "r_main.h"
 #include "w_wad.h"
 #include "z_zone.h"
 
+#include "SDL.h"
+
 //
 // Patches.
 // A patch holds one or more columns.
@@ -91,6 +96,30 @@ static short            SKY1;
 extern int              numtextures;
 extern texture_t        **textures;
 
+typedef struct
+{
+    unsigned short      patches;
+    unsigned short      posts;
+    unsigned short      posts_used;
+} count_t;
+
+// [BH] composites being built in the background by R_PrecacheCompositePatches()
+enum
+{
+    PRECACHE_NONE,
+    PRECACHE_PENDING,
+    PRECACHE_BUILDING,
+    PRECACHE_DONE
+};
+
+static SDL_atomic_t     *precachestates;
+static count_t          **precachecounts;
+static SDL_Thread       *precachethread;
+static SDL_atomic_t     precachefinished;
+static uint64_t         precachetime;
+static int              precachedcomposites;
+static int              precachedbytes;
+
 void R_InitPatches(void)
 {
     if (!patches)
@@ -99,18 +128,17 @@ void R_InitPatches(void)
     if (!texture_composites)
         texture_composites = calloc(numtextures, sizeof(rpatch_t));
 
+    if (!precachestates)
+        precachestates = calloc(numtextures, sizeof(SDL_atomic_t));
+
+    if (!precachecounts)
+        precachecounts = calloc(numtextures, sizeof(count_t *));
+
     BIGDOOR7 = R_CheckTextureNumForName("BIGDOOR7");
     FIREBLU1 = R_CheckTextureNumForName("FIREBLU1");
     SKY1 = R_CheckTextureNumForName("SKY1");
 }
 
-typedef struct
-{
-    unsigned short      patches;
-    unsigned short      posts;
-    unsigned short      posts_used;
-} count_t;
-
 static void switchPosts(rpost_t *post1, rpost_t *post2)
 {
     rpost_t     dummy;
@@ -141,7 +169,20 @@ static void removePostFromColumn(rcolumn_t *column, int post)
     column->numPosts--;
 }
 
-static void createTextureCompositePatch(int id)
+// [BH] The precache thread can't touch the zone, so the patches it needs are cached
+//  before it starts, and stay cached until it's finished.
+static const patch_t *cacheCompositePatch(int patchNum, dboolean background)
+{
+    return (const patch_t *)(background ? lumpinfo[patchNum]->cache : W_CacheLumpNum(patchNum, PU_STATIC));
+}
+
+static void releaseCompositePatch(int patchNum, dboolean background)
+{
+    if (!background && !precachethread)
+        W_ReleaseLumpNum(patchNum);
+}
+
+static count_t *allocateTextureCompositePatch(int id, dboolean background)
 {
     rpatch_t            *composite_patch = &texture_composites[id];
     texture_t           *texture = textures[id];
@@ -149,15 +190,12 @@ static void createTextureCompositePatch(int id)
     int                 patchNum;
     const patch_t       *oldPatch;
     const column_t      *oldColumn;
-    int                 i, x, y;
-    int                 oy, count;
+    int                 i, x;
     int                 pixelDataSize;
     int                 columnsDataSize;
     int                 postsDataSize;
     int                 dataSize;
     int                 numPostsTotal;
-    const unsigned char *oldColumnPixelData;
-    int                 numPostsUsedSoFar;
     count_t             *countsInColumn;
 
     composite_patch->width = texture->width;
@@ -176,7 +214,7 @@ static void createTextureCompositePatch(int id)
     {
         texpatch = &texture->patches[i];
         patchNum = texpatch->patch;
-        oldPatch = (const patch_t *)W_CacheLumpNum(patchNum, PU_CACHE);
+        oldPatch = cacheCompositePatch(patchNum, background);
 
         for (x = 0; x < SHORT(oldPatch->width); x++)
         {
@@ -198,7 +236,7 @@ static void createTextureCompositePatch(int id)
             }
         }
 
-        W_ReleaseLumpNum(patchNum);
+        releaseCompositePatch(patchNum, background);
     }
 
     postsDataSize = numPostsTotal * sizeof(rpost_t);
@@ -219,6 +257,25 @@ static void createTextureCompositePatch(int id)
     assert((((byte *)composite_patch->posts + numPostsTotal * sizeof(rpost_t))
         - (byte *)composite_patch->data) == dataSize);
 
+    if (background)
+        precachedbytes += dataSize;
+
+    return countsInColumn;
+}
+
+static void fillTextureCompositePatch(int id, count_t *countsInColumn, dboolean background)
+{
+    rpatch_t            *composite_patch = &texture_composites[id];
+    texture_t           *texture = textures[id];
+    texpatch_t          *texpatch;
+    int                 patchNum;
+    const patch_t       *oldPatch;
+    const column_t      *oldColumn;
+    int                 i, x, y;
+    int                 oy, count;
+    const unsigned char *oldColumnPixelData;
+    int                 numPostsUsedSoFar;
+
     memset(composite_patch->pixels, 0xFF, (composite_patch->width * composite_patch->height));
 
     numPostsUsedSoFar = 0;
@@ -238,7 +295,7 @@ static void createTextureCompositePatch(int id)
     {
         texpatch = &texture->patches[i];
         patchNum = texpatch->patch;
-        oldPatch = (const patch_t *)W_CacheLumpNum(patchNum, PU_CACHE);
+        oldPatch = cacheCompositePatch(patchNum, background);
 
         for (x = 0; x < SHORT(oldPatch->width); x++)
         {
@@ -308,7 +365,7 @@ static void createTextureCompositePatch(int id)
             }
         }
 
-        W_ReleaseLumpNum(patchNum);
+        releaseCompositePatch(patchNum, background);
     }
 
     for (x = 0; x < texture->width; x++)
@@ -388,26 +445,154 @@ static void createTextureCompositePatch(int id)
     free(countsInColumn);
 }
 
+static void createTextureCompositePatch(int id)
+{
+    fillTextureCompositePatch(id, allocateTextureCompositePatch(id, false), false);
+
+    // [BH] keep its patches cached until the precache thread has finished
+    if (precachethread)
+        SDL_AtomicSet(&precachestates[id], PRECACHE_DONE);
+}
+
+static int R_PrecacheThread(void *data)
+{
+    uint64_t    start = I_GetTimeUS();
+    int         i;
+
+    for (i = 0; i < numtextures; i++)
+        if (SDL_AtomicCAS(&precachestates[i], PRECACHE_PENDING, PRECACHE_BUILDING))
+        {
+            fillTextureCompositePatch(i, precachecounts[i], true);
+            precachecounts[i] = NULL;
+            SDL_AtomicSet(&precachestates[i], PRECACHE_DONE);
+        }
+
+    precachetime = I_GetTimeUS() - start;
+    SDL_AtomicSet(&precachefinished, 1);
+    return 0;
+}
+
+static void R_EndPrecache(void)
+{
+    int i;
+
+    for (i = 0; i < numtextures; i++)
+        if (SDL_AtomicGet(&precachestates[i]) != PRECACHE_NONE)
+        {
+            texture_t   *texture = textures[i];
+            int         j;
+
+            for (j = 0; j < texture->patchcount; j++)
+                W_ReleaseLumpNum(texture->patches[j].patch);
+
+            if (texture_composites[i].data && !texture_composites[i].locks)
+                Z_ChangeTag(texture_composites[i].data, PU_CACHE);
+
+            SDL_AtomicSet(&precachestates[i], PRECACHE_NONE);
+        }
+
+    C_Output("%s composite textures using %s bytes were built in %s milliseconds.",
+        commify(precachedcomposites), commify(precachedbytes),
+        striptrailingzero(precachetime / 1000.0f, 1));
+}
+
+//
+// R_PrecacheCompositePatches
+// [BH] Build the composites of every texture marked in hitlist on another thread while
+//  the wipe runs, so they aren't built the first time they're seen. Only the posts are
+//  counted and the memory allocated here, since the zone isn't thread-safe.
+//
+void R_PrecacheCompositePatches(byte *hitlist)
+{
+    int i;
+
+    R_FinishPrecache(true);
+
+    precachedcomposites = 0;
+    precachedbytes = 0;
+
+    for (i = 0; i < numtextures; i++)
+        if (hitlist[i] && !texture_composites[i].data)
+        {
+            texture_t   *texture = textures[i];
+            int         j;
+
+            for (j = 0; j < texture->patchcount; j++)
+                W_CacheLumpNum(texture->patches[j].patch, PU_STATIC);
+
+            precachecounts[i] = allocateTextureCompositePatch(i, true);
+            SDL_AtomicSet(&precachestates[i], PRECACHE_PENDING);
+            precachedcomposites++;
+        }
+
+    if (!precachedcomposites)
+        return;
+
+    SDL_AtomicSet(&precachefinished, 0);
+
+    if (!(precachethread = SDL_CreateThread(R_PrecacheThread, "R_PrecacheThread", NULL)))
+    {
+        R_PrecacheThread(NULL);
+        R_EndPrecache();
+    }
+}
+
+//
+// R_FinishPrecache
+// [BH] Called by the main thread once a frame, and before precaching the next level.
+//
+void R_FinishPrecache(dboolean wait)
+{
+    if (!precachethread || (!wait && !SDL_AtomicGet(&precachefinished)))
+        return;
+
+    SDL_WaitThread(precachethread, NULL);
+    precachethread = NULL;
+    R_EndPrecache();
+}
+
 rpatch_t *R_CacheTextureCompositePatchNum(int id)
 {
     if (!texture_composites)
         I_Error("R_CacheTextureCompositePatchNum: Composite patches not initialized");
 
+    R_LockRenderCache();
+
     if (!texture_composites[id].data)
         createTextureCompositePatch(id);
+    else if (precachethread)
+    {
+        // [BH] build it now if the precache thread hasn't got to it yet,
+        //  otherwise wait for the precache thread to finish building it
+        if (SDL_AtomicCAS(&precachestates[id], PRECACHE_PENDING, PRECACHE_BUILDING))
+        {
+            fillTextureCompositePatch(id, precachecounts[id], true);
+            precachecounts[id] = NULL;
+            SDL_AtomicSet(&precachestates[id], PRECACHE_DONE);
+        }
+        else
+            while (SDL_AtomicGet(&precachestates[id]) == PRECACHE_BUILDING)
+                SDL_Delay(0);
+    }
 
     // cph - if wasn't locked but now is, tell z_zone to hold it
     if (!texture_composites[id].locks)
         Z_ChangeTag(texture_composites[id].data, PU_STATIC);
     texture_composites[id].locks++;
 
+    R_UnlockRenderCache();
+
     return &texture_composites[id];
 }
 
 void R_UnlockTextureCompositePatchNum(int id)
 {
+    R_LockRenderCache();
+
     if (!--texture_composites[id].locks)
         Z_ChangeTag(texture_composites[id].data, PU_CACHE);
+
+    R_UnlockRenderCache();
 }
 
 rcolumn_t *R_GetPatchColumnWrapped(rpatch_t *patch, int columnIndex)
@@ -77,5 +77,7 @@ rcolumn_t *R_GetPatchColumnWrapped(rpatch_t *patch, int columnIndex);
 rcolumn_t *R_GetPatchColumnClamped(rpatch_t *patch, int columnIndex);
 
 void R_InitPatches(void);
+void R_PrecacheCompositePatches(byte *hitlist);
+void R_FinishPrecache(dboolean wait);
 
 #endif
@@ -38,18 +38,24 @@
 
 #include "c_console.h"
 #include "doomstat.h"
+#include "i_system.h"
 #include "p_local.h"
 #include "r_sky.h"
 #include "w_wad.h"
 #include "z_zone.h"
 
 #define MAXVISPLANES    128                             // must be a power of 2
+#define VISPLANEBLOCK   64
 
-static visplane_t       *visplanes[MAXVISPLANES];       // killough
-static visplane_t       *freetail;                      // killough
-static visplane_t       **freehead = &freetail;         // killough
-visplane_t              *floorplane;
-visplane_t              *ceilingplane;
+static THREADLOCAL visplane_t   *visplanes[MAXVISPLANES];   // killough
+
+// [BH] Visplanes are allocated in blocks that are never freed, and are all
+//  handed out again at the start of each frame.
+static THREADLOCAL visplane_t   **visplaneblocks;
+static THREADLOCAL int          numvisplaneblocks;
+static THREADLOCAL int          numvisplanes;
+THREADLOCAL visplane_t          *floorplane;
+THREADLOCAL visplane_t          *ceilingplane;
 
 // killough -- hash function for visplanes
 // Empirically verified to be fairly uniform:
@@ -57,38 +63,40 @@ visplane_t              *ceilingplane;
     (((unsigned int)(picnum) * 3 + (unsigned int)(lightlevel) + \
     (unsigned int)(height) * 7) & (MAXVISPLANES - 1))
 
-size_t                 maxopenings;
-int                    *openings;                       // dropoff overflow
-int                    *lastopening;                    // dropoff overflow
+THREADLOCAL size_t              maxopenings;
+THREADLOCAL int                 *openings;                  // dropoff overflow
+THREADLOCAL int                 *lastopening;               // dropoff overflow
 
 // Clip values are the solid pixel bounding the range.
 //  floorclip starts out SCREENHEIGHT
 //  ceilingclip starts out -1
-int                     floorclip[SCREENWIDTH];         // dropoff overflow
-int                     ceilingclip[SCREENWIDTH];       // dropoff overflow
+THREADLOCAL int                 floorclip[SCREENWIDTH];     // dropoff overflow
+THREADLOCAL int                 ceilingclip[SCREENWIDTH];   // dropoff overflow
 
 // spanstart holds the start of a plane span
 // initialized to 0 at start
-static int              spanstart[SCREENHEIGHT];
+static THREADLOCAL int          spanstart[SCREENHEIGHT];
 
 // texture mapping
-static lighttable_t     **planezlight;
-static fixed_t          planeheight;
+static THREADLOCAL lighttable_t **planezlight;
+static THREADLOCAL fixed_t      planeheight;
 
-static fixed_t          xoffs, yoffs;                   // killough 2/28/98: flat offsets
+static THREADLOCAL fixed_t      xoffs, yoffs;               // killough 2/28/98: flat offsets
 
-fixed_t                 yslope[SCREENHEIGHT];
-fixed_t                 distscale[SCREENWIDTH];
+fixed_t                         yslope[SCREENHEIGHT];
+fixed_t                         distscale[SCREENWIDTH];
 
-fixed_t                 cachedheight[SCREENHEIGHT];
-fixed_t                 cacheddistance[SCREENHEIGHT];
-fixed_t                 cachedxstep[SCREENHEIGHT];
-fixed_t                 cachedystep[SCREENHEIGHT];
+THREADLOCAL fixed_t             cachedheight[SCREENHEIGHT];
+THREADLOCAL fixed_t             cacheddistance[SCREENHEIGHT];
+THREADLOCAL fixed_t             cachedxstep[SCREENHEIGHT];
+THREADLOCAL fixed_t             cachedystep[SCREENHEIGHT];
 
 int                     skycolor;
 
 dboolean                r_liquid_swirl = r_liquid_swirl_default;
 int                     r_skycolor = r_skycolor_default;
+int                     r_visplanes_bytes;
+int                     r_visplanes_total;
 
 //
 // R_MapPlane
@@ -154,9 +162,8 @@ void R_ClearPlanes(void)
     // texture calculation
     memset(cachedheight, 0, sizeof(cachedheight));
 
-    for (i = 0; i < MAXVISPLANES; i++)  // new code -- killough
-        for (*freehead = visplanes[i], visplanes[i] = NULL; *freehead;)
-            freehead = &(*freehead)->next;
+    memset(visplanes, 0, sizeof(visplanes));
+    numvisplanes = 0;
 
     lastopening = openings;
 }
@@ -164,17 +171,40 @@ void R_ClearPlanes(void)
 // New function, by Lee Killough
 static visplane_t *new_visplane(unsigned hash)
 {
-    visplane_t  *check = freetail;
+    visplane_t  *check;
+
+    if (numvisplanes == numvisplaneblocks * VISPLANEBLOCK)
+    {
+        visplaneblocks = Z_Realloc(visplaneblocks, (numvisplaneblocks + 1) * sizeof(*visplaneblocks));
 
-    if (!check)
-        check = calloc(1, sizeof(*check));
-    else if (!(freetail = freetail->next))
-        freehead = &freetail;
+        if (!(visplaneblocks[numvisplaneblocks++] = malloc(VISPLANEBLOCK * sizeof(visplane_t))))
+            I_Error("new_visplane: Failure trying to allocate %i bytes",
+                (int)(VISPLANEBLOCK * sizeof(visplane_t)));
+    }
+
+    check = &visplaneblocks[numvisplanes / VISPLANEBLOCK][numvisplanes % VISPLANEBLOCK];
+    numvisplanes++;
     check->next = visplanes[hash];
     visplanes[hash] = check;
     return check;
 }
 
+//
+// R_ClearPlaneColumns
+// [BH] Only the columns of a visplane between minx and maxx are ever looked
+//  at, so they are cleared as the visplane grows rather than all at once.
+//
+static void R_ClearPlaneColumns(visplane_t *pl, int start, int stop)
+{
+    int x;
+
+    for (x = start; x <= stop; x++)
+    {
+        pl->top[x] = USHRT_MAX;
+        pl->bottom[x] = 0;
+    }
+}
+
 //
 // R_FindPlane
 //
@@ -207,8 +237,6 @@ visplane_t *R_FindPlane(fixed_t height, int picnum, int lightlevel, fixed_t xoff
     check->xoffs = xoffs;                                      // killough 2/28/98: Save offsets
     check->yoffs = yoffs;
 
-    memset(check->top, USHRT_MAX, sizeof(check->top));
-
     return check;
 }
 
@@ -251,6 +279,14 @@ visplane_t *R_CheckPlane(visplane_t *pl, int start, int stop)
     // visplane (e.g. both skies)
     if (!(pl == floorplane && markceiling && floorplane == ceilingplane) && x > intrh)
     {
+        if (pl->minx > pl->maxx)
+            R_ClearPlaneColumns(pl, unionl, unionh);
+        else
+        {
+            R_ClearPlaneColumns(pl, unionl, pl->minx - 1);
+            R_ClearPlaneColumns(pl, pl->maxx + 1, unionh);
+        }
+
         pl->minx = unionl;
         pl->maxx = unionh;
     }
@@ -268,7 +304,7 @@ visplane_t *R_CheckPlane(visplane_t *pl, int start, int stop)
         pl = new_pl;
         pl->minx = start;
         pl->maxx = stop;
-        memset(pl->top, USHRT_MAX, sizeof(pl->top));
+        R_ClearPlaneColumns(pl, start, stop);
     }
 
     return pl;
@@ -311,28 +347,22 @@ static void R_MakeSpans(visplane_t *pl)
 // 1 cycle per 32 units (2 in 64)
 #define SWIRLFACTOR2    (8192 / 32)
 
-static byte     *normalflat;
-static byte     distortedflat[4096];
+static int                  swirltic = -1;
+static int                  swirloffset[4096];
+
+static THREADLOCAL int      distortedflatnum = -1;
+static THREADLOCAL int      distortedswirltic = -1;
+static THREADLOCAL byte     distortedflat[4096];
 
 //
-// R_DistortedFlat
+// R_UpdateDistortedFlats
 //
-// Generates a distorted flat from a normal one using a two-dimensional
-// sine wave pattern.
+// Builds the sine wave pattern used to distort flats for this tic. Called once
+// a frame before any render strips start, so they all share the same pattern.
 //
-static byte *R_DistortedFlat(int flatnum)
+void R_UpdateDistortedFlats(void)
 {
-    static int  lastflat = -1;
-    static int  swirltic = -1;
-    static int  offset[4096];
-    int         i;
-    int         leveltic = gametic;
-
-    // Already swirled this one?
-    if (leveltic == swirltic && lastflat == flatnum)
-        return distortedflat;
-
-    lastflat = flatnum;
+    int leveltic = gametic;
 
     // built this tic?
     if (leveltic != swirltic && !freeze && (!consoleactive || swirltic == -1) && !menuactive
@@ -357,16 +387,37 @@ static byte *R_DistortedFlat(int flatnum)
                 y1 = y + 128 + ((finesine[sinvalue] * AMP) >> FRACBITS)
                     + ((finesine[sinvalue2] * AMP2) >> FRACBITS);
 
-                offset[(y << 6) + x] = ((y1 & 63) << 6) + (x1 & 63);
+                swirloffset[(y << 6) + x] = ((y1 & 63) << 6) + (x1 & 63);
             }
 
         swirltic = gametic;
     }
+}
+
+//
+// R_DistortedFlat
+//
+// Generates a distorted flat from a normal one using a two-dimensional
+// sine wave pattern.
+//
+static byte *R_DistortedFlat(int flatnum)
+{
+    byte    *normalflat;
+    int     i;
 
+    // Already swirled this one?
+    if (swirltic == distortedswirltic && flatnum == distortedflatnum)
+        return distortedflat;
+
+    distortedflatnum = flatnum;
+    distortedswirltic = swirltic;
+
+    R_LockRenderCache();
     normalflat = W_CacheLumpNum(firstflat + flatnum, PU_LEVEL);
+    R_UnlockRenderCache();
 
     for (i = 0; i < 4096; i++)
-        distortedflat[i] = normalflat[offset[i]];
+        distortedflat[i] = normalflat[swirloffset[i]];
 
     return distortedflat;
 }
@@ -379,11 +430,24 @@ void R_DrawPlanes(void)
 {
     int i;
 
+    // [BH] only count the visplanes of the first render strip
+    if (!stripx1)
+    {
+        r_visplanes_total = numvisplanes;
+        r_visplanes_bytes = (int)(numvisplaneblocks * VISPLANEBLOCK * sizeof(visplane_t)
+            + maxopenings * sizeof(*openings));
+    }
+
     for (i = 0; i < MAXVISPLANES; i++)
     {
         visplane_t      *pl;
 
         for (pl = visplanes[i]; pl; pl = pl->next)
+        {
+            // [BH] only draw the columns that are in this render strip
+            pl->minx = MAX(pl->minx, stripx1);
+            pl->maxx = MIN(pl->maxx, stripx2);
+
             if (pl->minx <= pl->maxx)
             {
                 int     picnum = pl->picnum;
@@ -469,8 +533,14 @@ void R_DrawPlanes(void)
                     dboolean        swirling = (isliquid[picnum] && r_liquid_swirl && !freeze);
                     int             lumpnum = firstflat + flattranslation[picnum];
 
-                    ds_source = (swirling ? R_DistortedFlat(picnum) :
-                        W_CacheLumpNum(lumpnum, PU_STATIC));
+                    if (swirling)
+                        ds_source = R_DistortedFlat(picnum);
+                    else
+                    {
+                        R_LockRenderCache();
+                        ds_source = W_CacheLumpNum(lumpnum, PU_STATIC);
+                        R_UnlockRenderCache();
+                    }
 
                     xoffs = pl->xoffs;  // killough 2/28/98: Add offsets
                     yoffs = pl->yoffs;
@@ -480,12 +550,18 @@ void R_DrawPlanes(void)
                         + extralight * LIGHTBRIGHT, LIGHTLEVELS - 1)];
 
                     pl->top[pl->minx - 1] = pl->top[pl->maxx + 1] = USHRT_MAX;
+                    pl->bottom[pl->minx - 1] = pl->bottom[pl->maxx + 1] = 0;
 
                     R_MakeSpans(pl);
 
                     if (!swirling)
+                    {
+                        R_LockRenderCache();
                         W_ReleaseLumpNum(lumpnum);
+                        R_UnlockRenderCache();
+                    }
                 }
             }
+        }
     }
 }
@@ -43,21 +43,22 @@
 #define PL_SKYFLAT      0x80000000
 
 // Visplane related.
-extern  int     *lastopening;
+extern THREADLOCAL int      *lastopening;
 
-extern int      floorclip[];
-extern int      ceilingclip[];
+extern THREADLOCAL int      floorclip[];
+extern THREADLOCAL int      ceilingclip[];
 
-extern fixed_t  yslope[];
-extern fixed_t  distscale[];
+extern fixed_t              yslope[];
+extern fixed_t              distscale[];
 
-extern dboolean markceiling;
+extern THREADLOCAL dboolean markceiling;
 
 extern dboolean r_brightmaps;
 
 void R_ClearPlanes(void);
 
 void R_DrawPlanes(void);
+void R_UpdateDistortedFlats(void);
 
 visplane_t *R_FindPlane(fixed_t height, int picnum, int lightlevel, fixed_t xoffs, fixed_t yoffs);
 
@@ -42,68 +42,66 @@
 
 // killough 1/6/98: replaced globals with statics where appropriate
 
-static dboolean segtextured;            // True if any of the segs textures might be visible.
+static THREADLOCAL dboolean segtextured;        // True if any of the segs textures might be visible.
 
-static dboolean markfloor;              // False if the back side is the same plane.
-dboolean        markceiling;
+static THREADLOCAL dboolean markfloor;          // False if the back side is the same plane.
+THREADLOCAL dboolean        markceiling;
 
-static dboolean maskedtexture;
-static int      toptexture;
-static int      midtexture;
-static int      bottomtexture;
+static THREADLOCAL dboolean maskedtexture;
+static THREADLOCAL int      toptexture;
+static THREADLOCAL int      midtexture;
+static THREADLOCAL int      bottomtexture;
 
-static fixed_t  toptexheight;
-static fixed_t  midtexheight;
-static fixed_t  bottomtexheight;
+static THREADLOCAL fixed_t  toptexheight;
+static THREADLOCAL fixed_t  midtexheight;
+static THREADLOCAL fixed_t  bottomtexheight;
 
-static byte     *toptexfullbright;
-static byte     *midtexfullbright;
-static byte     *bottomtexfullbright;
+static THREADLOCAL byte     *toptexfullbright;
+static THREADLOCAL byte     *midtexfullbright;
+static THREADLOCAL byte     *bottomtexfullbright;
 
-angle_t         rw_normalangle;
-fixed_t         rw_distance;
+THREADLOCAL angle_t         rw_normalangle;
+THREADLOCAL fixed_t         rw_distance;
 
 //
 // regular wall
 //
-static int      rw_x;
-static int      rw_stopx;
-static angle_t  rw_centerangle;
-static fixed_t  rw_offset;
-static fixed_t  rw_scale;
-static fixed_t  rw_scalestep;
-static fixed_t  rw_midtexturemid;
-static fixed_t  rw_toptexturemid;
-static fixed_t  rw_bottomtexturemid;
+static THREADLOCAL int      rw_x;
+static THREADLOCAL int      rw_stopx;
+static THREADLOCAL angle_t  rw_centerangle;
+static THREADLOCAL fixed_t  rw_offset;
+static THREADLOCAL fixed_t  rw_scale;
+static THREADLOCAL fixed_t  rw_scalestep;
+static THREADLOCAL fixed_t  rw_midtexturemid;
+static THREADLOCAL fixed_t  rw_toptexturemid;
+static THREADLOCAL fixed_t  rw_bottomtexturemid;
 
-static int      worldtop;
-static int      worldbottom;
-static int      worldhigh;
-static int      worldlow;
+static THREADLOCAL int      worldtop;
+static THREADLOCAL int      worldbottom;
+static THREADLOCAL int      worldhigh;
+static THREADLOCAL int      worldlow;
 
-static int64_t  pixhigh;
-static int64_t  pixlow;
-static fixed_t  pixhighstep;
-static fixed_t  pixlowstep;
+static THREADLOCAL int64_t  pixhigh;
+static THREADLOCAL int64_t  pixlow;
+static THREADLOCAL fixed_t  pixhighstep;
+static THREADLOCAL fixed_t  pixlowstep;
 
-static int64_t  topfrac;
-static fixed_t  topstep;
+static THREADLOCAL int64_t  topfrac;
+static THREADLOCAL fixed_t  topstep;
 
-static int64_t  bottomfrac;
-static fixed_t  bottomstep;
+static THREADLOCAL int64_t  bottomfrac;
+static THREADLOCAL fixed_t  bottomstep;
 
-lighttable_t    **walllights;
+THREADLOCAL lighttable_t    **walllights;
 
-static int      *maskedtexturecol;      // dropoff overflow
+static THREADLOCAL int      *maskedtexturecol;  // dropoff overflow
 
 dboolean        r_brightmaps = r_brightmaps_default;
 dboolean        r_liquid_current = r_liquid_current_default;
 
 extern fixed_t  animatedliquiddiff;
-extern fixed_t  animatedliquidxoffs;
-extern fixed_t  animatedliquidyoffs;
 
-extern dboolean doorclosed;
+extern THREADLOCAL dboolean doorclosed;
 extern dboolean r_dither;
 extern dboolean r_liquid_bob;
 extern dboolean r_textures;
@@ -148,10 +146,10 @@ extern dboolean r_translucency;
 //   increasing the precision of various renderer variables, and,
 //   possibly, creating a noticeable performance penalty.
 //
-static int      max_rwscale = 64 * FRACUNIT;
-static int      heightbits = 12;
-static int      heightunit = (1 << 12);
-static int      invhgtbits = 4;
+static THREADLOCAL int  max_rwscale = 64 * FRACUNIT;
+static THREADLOCAL int  heightbits = 12;
+static THREADLOCAL int  heightunit = (1 << 12);
+static THREADLOCAL int  invhgtbits = 4;
 
 typedef struct
 {
@@ -168,36 +166,29 @@ static const scale_values_t scale_values[9] =
 
 void R_FixWiggle(sector_t *sector)
 {
-    static int  lastheight;
+    static THREADLOCAL int  lastheight;
 
-    // disallow negative heights, force cache initialization
-    int         height = MAX(1, (sector->interpceilingheight
-                    - sector->interpfloorheight) >> FRACBITS);
+    // disallow negative heights
+    int                     height = MAX(1, (sector->interpceilingheight
+                                - sector->interpfloorheight) >> FRACBITS);
 
     // early out?
     if (height != lastheight)
     {
         const scale_values_t    *svp;
+        int                     scaleindex = 0;
 
         lastheight = height;
+        height >>= 7;
 
-        // initialize, or handle moving sector
-        if (height != sector->cachedheight)
-        {
-            int scaleindex = 0;
-
-            sector->cachedheight = height;
-            height >>= 7;
-
-            // calculate adjustment
-            while ((height >>= 1))
-                scaleindex++;
-
-            sector->scaleindex = scaleindex;
-        }
+        // calculate adjustment
+        // [BH] this is no longer cached in the sector, which render strips
+        //  would otherwise be writing to at the same time
+        while ((height >>= 1))
+            scaleindex++;
 
         // fine-tune renderer for this wall
-        svp = &scale_values[sector->scaleindex];
+        svp = &scale_values[scaleindex];
         max_rwscale = svp->clamp;
         heightbits = svp->heightbits;
         heightunit = 1 << heightbits;
@@ -244,6 +235,13 @@ void R_RenderMaskedSegRange(drawseg_t *ds, int x1, int x2)
     rpatch_t    *patch;
     sector_t    tempsec;        // killough 4/13/98
 
+    // [BH] only draw the columns that are in this render strip
+    x1 = MAX(x1, stripx1);
+    x2 = MIN(x2, stripx2);
+
+    if (x1 > x2)
+        return;
+
     // Calculate light table.
     // Use different light tables for horizontal / vertical.
     curline = ds->curline;
@@ -340,8 +338,43 @@ void R_RenderSegLoop(void)
 {
     fixed_t     texturecolumn = 0;
     dboolean    usebrightmaps = (r_brightmaps && !fixedcolormap && fullcolormap == colormaps[0]);
+    rpatch_t    *midpatch = NULL;
+    rpatch_t    *toppatch = NULL;
+    rpatch_t    *bottompatch = NULL;
+    int         stopx = MIN(rw_stopx, stripx2 + 1);
+
+    // [BH] skip to the first column in this render strip. Everything is stepped
+    //  linearly, so this gives exactly the values that stepping there one
+    //  column at a time would have.
+    if (rw_x < stripx1)
+    {
+        int skip = MIN(stripx1, rw_stopx) - rw_x;
+
+        rw_x += skip;
+        rw_scale += (fixed_t)((int64_t)skip * rw_scalestep);
+        topfrac += (int64_t)skip * topstep;
+        bottomfrac += (int64_t)skip * bottomstep;
+        pixhigh += (int64_t)skip * pixhighstep;
+        pixlow += (int64_t)skip * pixlowstep;
+    }
+
+    if (rw_x >= stopx)
+        return;
 
-    for (; rw_x < rw_stopx; rw_x++)
+    // [BH] lock the composite of each texture once for the whole seg rather
+    //  than once for every column
+    if (midtexture)
+        midpatch = R_CacheTextureCompositePatchNum(midtexture);
+    else
+    {
+        if (toptexture)
+            toppatch = R_CacheTextureCompositePatchNum(toptexture);
+
+        if (bottomtexture)
+            bottompatch = R_CacheTextureCompositePatchNum(bottomtexture);
+    }
+
+    for (; rw_x < stopx; rw_x++)
     {
         // mark floor / ceiling areas
         int     yl = (int)((topfrac + heightunit - 1) >> heightbits);
@@ -414,8 +447,7 @@ void R_RenderSegLoop(void)
                 dc_yh = yh;
 
                 dc_texturemid = rw_midtexturemid;
-                dc_source = R_GetTextureColumn(R_CacheTextureCompositePatchNum(midtexture),
-                    texturecolumn);
+                dc_source = R_GetTextureColumn(midpatch, texturecolumn);
                 dc_texheight = midtexheight;
 
                 // [BH] apply brightmap
@@ -424,8 +456,6 @@ void R_RenderSegLoop(void)
                     fbwallcolfunc();
                 else
                     wallcolfunc();
-
-                R_UnlockTextureCompositePatchNum(midtexture);
             }
 
             ceilingclip[rw_x] = viewheight;
@@ -452,8 +482,7 @@ void R_RenderSegLoop(void)
                         dc_yh = mid;
 
                         dc_texturemid = rw_toptexturemid;
-                        dc_source = R_GetTextureColumn(R_CacheTextureCompositePatchNum(toptexture),
-                            texturecolumn);
+                        dc_source = R_GetTextureColumn(toppatch, texturecolumn);
                         dc_texheight = toptexheight;
 
                         // [BH] apply brightmap
@@ -462,8 +491,6 @@ void R_RenderSegLoop(void)
                             fbwallcolfunc();
                         else
                             wallcolfunc();
-
-                        R_UnlockTextureCompositePatchNum(toptexture);
                     }
 
                     ceilingclip[rw_x] = mid;
@@ -495,8 +522,7 @@ void R_RenderSegLoop(void)
                         dc_yh = yh;
 
                         dc_texturemid = rw_bottomtexturemid;
-                        dc_source = R_GetTextureColumn(R_CacheTextureCompositePatchNum(bottomtexture),
-                            texturecolumn);
+                        dc_source = R_GetTextureColumn(bottompatch, texturecolumn);
                         dc_texheight = bottomtexheight;
 
                         // [BH] apply brightmap
@@ -505,8 +531,6 @@ void R_RenderSegLoop(void)
                             fbwallcolfunc();
                         else
                             wallcolfunc();
-
-                        R_UnlockTextureCompositePatchNum(bottomtexture);
                     }
 
                     floorclip[rw_x] = mid;
@@ -528,6 +552,15 @@ void R_RenderSegLoop(void)
         topfrac += topstep;
         bottomfrac += bottomstep;
     }
+
+    if (midpatch)
+        R_UnlockTextureCompositePatchNum(midtexture);
+
+    if (toppatch)
+        R_UnlockTextureCompositePatchNum(toptexture);
+
+    if (bottompatch)
+        R_UnlockTextureCompositePatchNum(bottomtexture);
 }
 
 //
@@ -560,7 +593,9 @@ void R_StoreWallRange(int start, int stop)
     linedef = curline->linedef;
 
     // mark the segment as visible for automap
-    linedef->flags |= ML_MAPPED;
+    // [BH] render strips have their segs marked by R_FindVisibleSubsectors()
+    if (!stripx1 && stripx2 == viewwidth - 1)
+        linedef->flags |= ML_MAPPED;
 
     // [BH] if in automap, we're done now that line is mapped
     if (automapactive)
@@ -598,9 +633,9 @@ void R_StoreWallRange(int start, int stop)
 
     // killough 1/6/98, 2/1/98: remove limit on openings
     {
-        extern int      *openings;              // dropoff overflow
-        extern size_t   maxopenings;
-        size_t          pos = lastopening - openings;
+        extern THREADLOCAL int      *openings;  // dropoff overflow
+        extern THREADLOCAL size_t   maxopenings;
+        size_t                      pos = lastopening - openings;
         size_t          need = (rw_stopx - start) * sizeof(*lastopening) + pos;
 
         if (need > maxopenings)
@@ -637,18 +672,9 @@ void R_StoreWallRange(int start, int stop)
     worldbottom = frontsector->interpfloorheight - viewz;
 
     // [BH] animate liquid sectors
-    if (frontsector->isliquid && !freeze)
-    {
-        if (r_liquid_bob && (frontsector->heightsec == -1
-            || viewz > sectors[frontsector->heightsec].interpfloorheight))
-            worldbottom += animatedliquiddiff;
-
-        if (r_liquid_current && frontsector->heightsec == -1)
-        {
-            frontsector->floor_xoffs = animatedliquidxoffs;
-            frontsector->floor_yoffs = animatedliquidyoffs;
-        }
-    }
+    if (frontsector->isliquid && !freeze && r_liquid_bob && (frontsector->heightsec == -1
+        || viewz > sectors[frontsector->heightsec].interpfloorheight))
+        worldbottom += animatedliquiddiff;
 
     R_FixWiggle(frontsector);
 
@@ -726,20 +752,16 @@ void R_StoreWallRange(int start, int stop)
         // from being displayed on the automap.
         //
         // killough 4/7/98: make doorclosed external variable
+        if (doorclosed || backsector->interpceilingheight <= frontsector->interpfloorheight)
         {
-            extern dboolean     doorclosed;
-
-            if (doorclosed || backsector->interpceilingheight <= frontsector->interpfloorheight)
-            {
-                ds_p->sprbottomclip = negonearray;
-                ds_p->silhouette |= SIL_BOTTOM;
-            }
+            ds_p->sprbottomclip = negonearray;
+            ds_p->silhouette |= SIL_BOTTOM;
+        }
 
-            if (doorclosed || backsector->interpfloorheight >= frontsector->interpceilingheight)
-            {
-                ds_p->sprtopclip = screenheightarray;
-                ds_p->silhouette |= SIL_TOP;
-            }
+        if (doorclosed || backsector->interpfloorheight >= frontsector->interpceilingheight)
+        {
+            ds_p->sprtopclip = screenheightarray;
+            ds_p->silhouette |= SIL_TOP;
         }
 
         worldhigh = backsector->interpceilingheight - viewz;
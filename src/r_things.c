@@ -91,7 +91,6 @@ dboolean                r_playersprites = r_playersprites_default;
 
 extern fixed_t          animatedliquiddiff;
 extern dboolean         drawbloodsplats;
-extern dboolean         inhelpscreens;
 extern dboolean         notranslucency;
 extern dboolean         r_liquid_bob;
 extern dboolean         r_shadows;
@@ -312,7 +311,8 @@ static unsigned int             num_vissprite;
 static unsigned int             num_bloodsplatvissprite;
 static unsigned int             num_vissprite_alloc;
 
-static bloodsplatvissprite_t    bloodsplatvissprites[r_bloodsplats_max_max];
+static bloodsplatvissprite_t    *bloodsplatvissprites;
+static unsigned int             num_bloodsplatvissprite_alloc;
 
 //
 // R_InitSprites
@@ -348,6 +348,9 @@ void R_ClearSprites(void)
 
     num_vissprite = 0;
     num_bloodsplatvissprite = 0;
+
+    pausesprites = (menuactive || paused || consoleactive);
+    interpolatesprites = (vid_capfps != TICRATE && !pausesprites);
 }
 
 //
@@ -443,14 +446,13 @@ static vissprite_t *R_NewVisSprite(fixed_t scale)
 //
 // R_BlastSpriteColumn
 //
-int             *mfloorclip;
-int             *mceilingclip;
+THREADLOCAL int         *mfloorclip;
+THREADLOCAL int         *mceilingclip;
 
-fixed_t         spryscale;
-int64_t         sprtopscreen;
-int             fuzzpos;
+THREADLOCAL fixed_t     spryscale;
+THREADLOCAL int64_t     sprtopscreen;
 
-static int64_t  shift;
+static THREADLOCAL int64_t  shift;
 
 static void R_BlastSpriteColumn(column_t *column)
 {
@@ -537,13 +539,19 @@ static void R_BlastShadowColumn(column_t *column)
 void R_DrawVisSprite(vissprite_t *vis)
 {
     fixed_t             frac;
-    const fixed_t       startfrac = vis->startfrac;
     const fixed_t       xiscale = vis->xiscale;
-    const fixed_t       x2 = vis->x2;
-    const byte          *patch = W_CacheLumpNum(vis->patch + firstspritelump, PU_CACHE);
-    const int           *columnofs = ((patch_t *)patch)->columnofs;
+    const int           x1 = MAX(vis->x1, stripx1);
+    const int           x2 = MIN(vis->x2, stripx2);
+    const fixed_t       startfrac = vis->startfrac + (x1 - vis->x1) * xiscale;
+    const byte          *patch;
+    const int           *columnofs;
     const mobj_t        *mobj = vis->mobj;
 
+    R_LockRenderCache();
+    patch = W_CacheLumpNum(vis->patch + firstspritelump, PU_CACHE);
+    R_UnlockRenderCache();
+    columnofs = ((patch_t *)patch)->columnofs;
+
     spryscale = vis->scale;
     dc_colormap = vis->colormap;
 
@@ -558,7 +566,7 @@ void R_DrawVisSprite(vissprite_t *vis)
                 + mobj->info->shadowoffset - viewz, spryscale);
             shift = (sprtopscreen * 9 / 10) >> FRACBITS;
 
-            for (dc_x = vis->x1, frac = startfrac; dc_x <= x2; dc_x++, frac += xiscale)
+            for (dc_x = x1, frac = startfrac; dc_x <= x2; dc_x++, frac += xiscale)
                 R_BlastShadowColumn((column_t *)(patch + LONG(columnofs[frac >> FRACBITS])));
         }
     }
@@ -596,9 +604,7 @@ void R_DrawVisSprite(vissprite_t *vis)
     else
         dc_baseclip = -1;
 
-    fuzzpos = 0;
-
-    for (dc_x = vis->x1, frac = startfrac; dc_x <= x2; dc_x++, frac += xiscale)
+    for (dc_x = x1, frac = startfrac; dc_x <= x2; dc_x++, frac += xiscale)
         R_BlastSpriteColumn((column_t *)(patch + LONG(columnofs[frac >> FRACBITS])));
 }
 
@@ -610,8 +616,13 @@ void R_DrawPVisSprite(vissprite_t *vis)
     fixed_t             frac = vis->startfrac;
     const fixed_t       xiscale = vis->xiscale;
     const fixed_t       x2 = vis->x2;
-    const byte          *patch = W_CacheLumpNum(vis->patch + firstspritelump, PU_CACHE);
-    const int           *columnofs = ((patch_t *)patch)->columnofs;
+    const byte          *patch;
+    const int           *columnofs;
+
+    R_LockRenderCache();
+    patch = W_CacheLumpNum(vis->patch + firstspritelump, PU_CACHE);
+    R_UnlockRenderCache();
+    columnofs = ((patch_t *)patch)->columnofs;
 
     dc_colormap = vis->colormap;
     colfunc = vis->colfunc;
@@ -623,7 +634,6 @@ void R_DrawPVisSprite(vissprite_t *vis)
     sprtopscreen = centeryfrac - FixedMul(dc_texturemid, spryscale);
 
     dc_baseclip = -1;
-    fuzzpos = 0;
 
     for (dc_x = vis->x1; dc_x <= x2; dc_x++, frac += xiscale)
         R_BlastSpriteColumn((column_t *)(patch + LONG(columnofs[frac >> FRACBITS])));
@@ -631,11 +641,17 @@ void R_DrawPVisSprite(vissprite_t *vis)
 
 void R_DrawBloodSplatVisSprite(bloodsplatvissprite_t *vis)
 {
-    fixed_t             frac = vis->startfrac;
     const fixed_t       xiscale = vis->xiscale;
-    const fixed_t       x2 = vis->x2;
-    const byte          *patch = W_CacheLumpNum(vis->patch + firstspritelump, PU_CACHE);
-    const int           *columnofs = ((patch_t *)patch)->columnofs;
+    const int           x1 = MAX(vis->x1, stripx1);
+    const int           x2 = MIN(vis->x2, stripx2);
+    fixed_t             frac = vis->startfrac + (x1 - vis->x1) * xiscale;
+    const byte          *patch;
+    const int           *columnofs;
+
+    R_LockRenderCache();
+    patch = W_CacheLumpNum(vis->patch + firstspritelump, PU_CACHE);
+    R_UnlockRenderCache();
+    columnofs = ((patch_t *)patch)->columnofs;
 
     colfunc = vis->colfunc;
 
@@ -645,9 +661,7 @@ void R_DrawBloodSplatVisSprite(bloodsplatvissprite_t *vis)
     spryscale = vis->scale;
     sprtopscreen = centeryfrac - FixedMul(vis->texturemid, spryscale);
 
-    fuzzpos = 0;
-
-    for (dc_x = vis->x1; dc_x <= x2; dc_x++, frac += xiscale)
+    for (dc_x = x1; dc_x <= x2; dc_x++, frac += xiscale)
         R_BlastBloodSplatColumn((column_t *)(patch + LONG(columnofs[frac >> FRACBITS])));
 }
 
@@ -877,7 +891,7 @@ void R_ProjectSprite(mobj_t *thing)
         vis->colormap = spritelights[BETWEEN(0, xscale >> LIGHTSCALESHIFT, MAXLIGHTSCALE - 1)];
 }
 
-static void R_ProjectBloodSplat(bloodsplat_t *splat)
+static void R_ProjectBloodSplat(const bloodsplat_t *splat, const sector_t *sec)
 {
     fixed_t                     tx;
 
@@ -933,6 +947,14 @@ static void R_ProjectBloodSplat(bloodsplat_t *splat)
         return;
 
     // store information in a vissprite
+    if (num_bloodsplatvissprite >= num_bloodsplatvissprite_alloc)
+    {
+        num_bloodsplatvissprite_alloc = (num_bloodsplatvissprite_alloc ?
+            num_bloodsplatvissprite_alloc * 2 : 256);
+        bloodsplatvissprites = Z_Realloc(bloodsplatvissprites,
+            num_bloodsplatvissprite_alloc * sizeof(*bloodsplatvissprites));
+    }
+
     vis = &bloodsplatvissprites[num_bloodsplatvissprite++];
 
     vis->scale = xscale;
@@ -942,7 +964,7 @@ static void R_ProjectBloodSplat(bloodsplat_t *splat)
     flags = splat->flags;
     vis->colfunc = ((flags & BSF_FUZZ) && pausesprites && r_textures ?
         R_DrawPausedFuzzColumn : splat->colfunc);
-    vis->texturemid = splat->sector->interpfloorheight - viewz;
+    vis->texturemid = sec->interpfloorheight - viewz;
     vis->x1 = MAX(0, x1);
     vis->x2 = MIN(x2, viewwidth - 1);
 
@@ -980,10 +1002,11 @@ void R_AddSprites(sector_t *sec, int lightlevel)
 
     if (drawbloodsplats && sec->interpfloorheight <= viewz)
     {
-        bloodsplat_t    *splat;
+        int     i;
 
-        for (splat = sec->splatlist; splat; splat = splat->snext)
-            R_ProjectBloodSplat(splat);
+        // [BH] project the newest splats first, so they're drawn over older ones
+        for (i = sec->numsplats - 1; i >= 0; i--)
+            R_ProjectBloodSplat(&sec->splats[(sec->firstsplat + i) % sec->maxsplats], sec);
     }
 
     drawshadows = (r_shadows && !fixedcolormap && sec->floorpic != skyflatnum);
@@ -1205,6 +1228,13 @@ static void R_DrawBloodSplatSprite(bloodsplatvissprite_t *spr)
     if (x1 >= x2)
         return;
 
+    // [BH] only draw the columns that are in this render strip
+    x1 = MAX(x1, stripx1);
+    x2 = MIN(x2, stripx2);
+
+    if (x1 > x2)
+        return;
+
     // initialize the clipping arrays
     for (i = x1; i <= x2; i++)
     {
@@ -1267,6 +1297,13 @@ static void R_DrawSprite(vissprite_t *spr)
     if (x1 >= x2)
         return;
 
+    // [BH] only draw the columns that are in this render strip
+    x1 = MAX(x1, stripx1);
+    x2 = MIN(x2, stripx2);
+
+    if (x1 > x2)
+        return;
+
     // initialize the clipping arrays
     for (i = x1; i <= x2; i++)
     {
@@ -1368,28 +1405,23 @@ static void R_DrawSprite(vissprite_t *spr)
 
 //
 // R_DrawMasked
+// [BH] Every render strip draws the same vissprites, so they're left in place.
 //
 void R_DrawMasked(void)
 {
-    drawseg_t   *ds;
-
-    pausesprites = (menuactive || paused || consoleactive);
-    interpolatesprites = (vid_capfps != TICRATE && !pausesprites);
+    drawseg_t       *ds;
+    unsigned int    i;
 
     // draw all blood splats
-    while (num_bloodsplatvissprite > 0)
-        R_DrawBloodSplatSprite(&bloodsplatvissprites[--num_bloodsplatvissprite]);
+    for (i = num_bloodsplatvissprite; i > 0; i--)
+        R_DrawBloodSplatSprite(&bloodsplatvissprites[i - 1]);
 
     // draw all other vissprites back to front
-    while (num_vissprite > 0)
-        R_DrawSprite(vissprite_ptrs[--num_vissprite]);
+    for (i = num_vissprite; i > 0; i--)
+        R_DrawSprite(vissprite_ptrs[i - 1]);
 
     // render any remaining masked mid textures
     for (ds = ds_p; ds-- > drawsegs;)
         if (ds->maskedtexturecol)
             R_RenderMaskedSegRange(ds, ds->x1, ds->x2);
-
-    // draw the psprites on top of everything
-    if (r_playersprites && !inhelpscreens)
-        R_DrawPlayerSprites();
 }
@@ -47,10 +47,10 @@ extern int      negonearray[SCREENWIDTH];
 extern int      screenheightarray[SCREENWIDTH];
 
 // vars for R_DrawMaskedColumn
-extern int      *mfloorclip;
-extern int      *mceilingclip;
-extern fixed_t  spryscale;
-extern int64_t  sprtopscreen;
+extern THREADLOCAL int      *mfloorclip;
+extern THREADLOCAL int      *mceilingclip;
+extern THREADLOCAL fixed_t  spryscale;
+extern THREADLOCAL int64_t  sprtopscreen;
 
 extern fixed_t  pspritexscale;
 extern fixed_t  pspriteyscale;
@@ -1495,8 +1495,14 @@ dboolean V_SavePNG(SDL_Window *window, char *path)
 
             if ((screenshot = SDL_CreateRGBSurface(0, width, height, 32, 0, 0, 0, 0)))
             {
-                if (!SDL_RenderReadPixels(renderer, NULL, SDL_PIXELFORMAT_ARGB8888,
-                    screenshot->pixels, screenshot->pitch))
+                int     readpixels;
+
+                I_LockRenderer();
+                readpixels = SDL_RenderReadPixels(renderer, NULL, SDL_PIXELFORMAT_ARGB8888,
+                    screenshot->pixels, screenshot->pitch);
+                I_UnlockRenderer();
+
+                if (!readpixels)
                     result = !IMG_SavePNG(screenshot, path);
 
                 SDL_FreeSurface(screenshot);
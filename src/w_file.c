@@ -36,12 +36,48 @@
 ========================================================================
 */
 
+#if defined(_WIN32)
+#include <Windows.h>
+#include <io.h>
+#else
+#include <sys/mman.h>
+#endif
+
 #include <stdio.h>
 
+#include "doomtype.h"
 #include "m_misc.h"
 #include "w_file.h"
 #include "z_zone.h"
 
+dboolean        nommap;
+
+//
+// [BH] Map the whole file into memory, so lumps can be used where they are instead of
+//  being read into the zone. The mapping is copy-on-write, since some lumps are changed
+//  once they are loaded, and those changes mustn't find their way back into the file.
+//
+static void W_MapFile(wad_file_t *wad)
+{
+#if defined(_WIN32)
+    HANDLE      file = (HANDLE)_get_osfhandle(_fileno(wad->fstream));
+    HANDLE      map = CreateFileMapping(file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+
+    if (map)
+    {
+        // the view keeps the mapping open once its handle is closed
+        wad->mapped = MapViewOfFile(map, FILE_MAP_COPY, 0, 0, 0);
+        CloseHandle(map);
+    }
+#else
+    void        *mapped = mmap(NULL, wad->length, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                    fileno(wad->fstream), 0);
+
+    if (mapped != MAP_FAILED)
+        wad->mapped = mapped;
+#endif
+}
+
 wad_file_t *W_OpenFile(char *path)
 {
     wad_file_t  *result;
@@ -54,12 +90,23 @@ wad_file_t *W_OpenFile(char *path)
     result = Z_Malloc(sizeof(wad_file_t), PU_STATIC, NULL);
     result->length = M_FileLength(fstream);
     result->fstream = fstream;
+    result->mapped = NULL;
+
+    if (!nommap && result->length)
+        W_MapFile(result);
 
     return result;
 }
 
 void W_CloseFile(wad_file_t *wad)
 {
+    if (wad->mapped)
+#if defined(_WIN32)
+        UnmapViewOfFile(wad->mapped);
+#else
+        munmap(wad->mapped, wad->length);
+#endif
+
     fclose(wad->fstream);
     Z_Free(wad);
 }
@@ -49,6 +49,9 @@ struct _wad_file_s
 {
     FILE                *fstream;
 
+    // [BH] The whole file, mapped copy-on-write, or NULL if it couldn't be.
+    byte                *mapped;
+
     // Length of the file, in bytes.
     unsigned int        length;
 
@@ -59,6 +62,9 @@ struct _wad_file_s
     int                 type;
 };
 
+// [BH] -nommap
+extern dboolean         nommap;
+
 // Open the specified file. Returns a pointer to a new wad_file_t
 // handle for the WAD file, or NULL if it could not be opened.
 wad_file_t *W_OpenFile(char *path);
@@ -36,12 +36,18 @@
 ========================================================================
 */
 
+#if defined(_WIN32)
+#include <Windows.h>
+#endif
+
 #include <ctype.h>
+#include <sys/stat.h>
 
 #include "c_console.h"
 #include "doomstat.h"
 #include "i_swap.h"
 #include "i_system.h"
+#include "i_timer.h"
 #include "m_misc.h"
 #include "w_wad.h"
 #include "z_zone.h"
@@ -58,6 +64,24 @@ typedef struct
     int         infotableofs;
 } PACKEDATTR wadinfo_t;
 
+// [BH] Header at the start of each file in the startup cache
+typedef struct
+{
+    char        identification[8];
+    int         version;
+    int         size;
+    uint64_t    key;
+} PACKEDATTR cacheheader_t;
+
+// [BH] Each WAD in the "wads" file in the startup cache, followed by its path
+typedef struct
+{
+    int64_t     length;
+    int64_t     mtime;
+    uint64_t    hash;
+    int         pathlength;
+} PACKEDATTR cachewad_t;
+
 typedef struct
 {
     int         filepos;
@@ -77,8 +101,35 @@ typedef struct
 lumpinfo_t              **lumpinfo;
 int                     numlumps;
 
-// Hash table for fast lookups
-static lumpindex_t      *lumphash;
+// [BH] Lumps used where they are in a mapped WAD, and lumps read into the zone
+int                     mappedlumps;
+int                     readlumps;
+uint64_t                mappedlumpsize;
+uint64_t                readlumpsize;
+
+// [BH] -nocache
+dboolean                nocache;
+
+// [BH] WADs whose contents had to be hashed by W_HashWADs(), and how long it took
+int                     hashedwads;
+int                     hashedwadstime;
+
+#define CACHEID         "DRCACHE"
+#define CACHEVERSION    2
+
+static char             *cachefolder;
+
+// [BH] Open-addressed table of packed lump names for fast lookups. Each slot
+// holds the last lump with that name, with earlier ones chained through next.
+static uint64_t         *lumpkeys;
+static lumpindex_t      *lumpslots;
+static unsigned int     lumpmask;
+
+// [BH] Lumps between the F_START/F_END and S_START/S_END markers
+static lumpindex_t      flatsstart = -1;
+static lumpindex_t      flatsend = -1;
+static lumpindex_t      spritesstart = -1;
+static lumpindex_t      spritesend = -1;
 
 static void ExtractFileBase(char *path, char *dest)
 {
@@ -112,6 +163,54 @@ unsigned int W_LumpNameHash(const char *s)
     return result;
 }
 
+// [BH] Pack an upper-cased lump name into a 64-bit key, zero-padded after the
+// first NUL so that keys compare the same way strncasecmp(a, b, 8) does.
+static uint64_t W_LumpNameKey(const char *name)
+{
+    uint64_t    key = 0;
+    int         i;
+
+    for (i = 0; i < 8 && name[i] != '\0'; i++)
+        key |= (uint64_t)toupper((byte)name[i]) << (i * 8);
+
+    return key;
+}
+
+static unsigned int W_LumpKeySlot(uint64_t key)
+{
+    return ((unsigned int)((key * 0x9E3779B97F4A7C15ull) >> 32) & lumpmask);
+}
+
+// [BH] Returns the last lump with the given key, or -1 if there isn't one.
+static lumpindex_t W_FindLumpKey(uint64_t key)
+{
+    unsigned int        slot = W_LumpKeySlot(key);
+    lumpindex_t         i;
+
+    while ((i = lumpslots[slot]) != -1)
+    {
+        if (lumpkeys[slot] == key)
+            return i;
+
+        slot = (slot + 1) & lumpmask;
+    }
+
+    return -1;
+}
+
+static void W_FreeHashTable(void)
+{
+    if (lumpslots)
+    {
+        Z_Free(lumpkeys);
+        Z_Free(lumpslots);
+        lumpkeys = NULL;
+        lumpslots = NULL;
+    }
+
+    flatsstart = flatsend = spritesstart = spritesend = -1;
+}
+
 static dboolean IsFreedoom(const char *iwadname)
 {
     FILE        *fp = fopen(iwadname, "rb");
@@ -228,11 +327,7 @@ wad_file_t *W_AddFile(char *filename, dboolean automatic)
 
     Z_Free(fileinfo);
 
-    if (lumphash)
-    {
-        Z_Free(lumphash);
-        lumphash = NULL;
-    }
+    W_FreeHashTable();
 
     C_Output("%s %s lump%s from %s <b>%s</b>.", (automatic ? "Automatically added" :
         "Added"), commify(numlumps - startlump), (numlumps - startlump == 1 ? "" : "s"),
@@ -339,25 +434,14 @@ lumpindex_t W_CheckNumForName(char *name)
     lumpindex_t i;
 
     // Do we have a hash table yet?
-    if (lumphash)
-    {
-        int     hash;
-
-        // We do! Excellent.
-        hash = W_LumpNameHash(name) % numlumps;
+    if (lumpslots)
+        return W_FindLumpKey(W_LumpNameKey(name));
 
-        for (i = lumphash[hash]; i != -1; i = lumpinfo[i]->next)
-            if (!strncasecmp(lumpinfo[i]->name, name, 8))
-                return i;
-    }
-    else
-    {
-        // We don't have a hash table generate yet. Linear search :-(
-        // scan backwards so patch lump files take precedence
-        for (i = numlumps - 1; i >= 0; i--)
-            if (!strncasecmp(lumpinfo[i]->name, name, 8))
-                return i;
-    }
+    // We don't have a hash table generate yet. Linear search :-(
+    // scan backwards so patch lump files take precedence
+    for (i = numlumps - 1; i >= 0; i--)
+        if (!strncasecmp(lumpinfo[i]->name, name, 8))
+            return i;
 
     // TFB. Not found.
     return -1;
@@ -375,21 +459,40 @@ int W_CheckMultipleLumps(char *name)
     if (FREEDOOM || hacx)
         return 3;
 
-    for (i = numlumps - 1; i >= 0; i--)
-        if (!strncasecmp(lumpinfo[i]->name, name, 8))
+    if (lumpslots)
+    {
+        for (i = W_CheckNumForName(name); i != -1; i = lumpinfo[i]->next)
             count++;
+    }
+    else
+    {
+        for (i = numlumps - 1; i >= 0; i--)
+            if (!strncasecmp(lumpinfo[i]->name, name, 8))
+                count++;
+    }
 
     return count;
 }
 
 //
 // W_RangeCheckNumForName
-// Linear Search that checks for a lump number ONLY
+// Checks for a lump number ONLY
 // inside a range, not all lumps.
 //
 lumpindex_t W_RangeCheckNumForName(lumpindex_t min, lumpindex_t max, char *name)
 {
     lumpindex_t i;
+    lumpindex_t result = -1;
+
+    if (lumpslots)
+    {
+        // [BH] the chain runs from the last lump to the first
+        for (i = W_CheckNumForName(name); i != -1 && i >= min; i = lumpinfo[i]->next)
+            if (i <= max)
+                result = i;
+
+        return result;
+    }
 
     for (i = min; i <= max; i++)
         if (!strncasecmp(lumpinfo[i]->name, name, 8))
@@ -398,6 +501,45 @@ lumpindex_t W_RangeCheckNumForName(lumpindex_t min, lumpindex_t max, char *name)
     return -1;
 }
 
+// [BH] Returns the last lump with the given name between two markers
+static lumpindex_t W_CheckNumForNameInSection(char *name, lumpindex_t start, lumpindex_t end)
+{
+    lumpindex_t i;
+
+    if (!lumpslots)
+    {
+        for (i = end; i >= start && i >= 0; i--)
+            if (!strncasecmp(lumpinfo[i]->name, name, 8))
+                return i;
+
+        return -1;
+    }
+
+    for (i = W_CheckNumForName(name); i != -1 && i >= start; i = lumpinfo[i]->next)
+        if (i <= end)
+            return i;
+
+    return -1;
+}
+
+//
+// W_CheckNumForFlat
+// Returns -1 if there's no flat with that name.
+//
+lumpindex_t W_CheckNumForFlat(char *name)
+{
+    return W_CheckNumForNameInSection(name, flatsstart, flatsend);
+}
+
+//
+// W_CheckNumForSprite
+// Returns -1 if there's no sprite with that name.
+//
+lumpindex_t W_CheckNumForSprite(char *name)
+{
+    return W_CheckNumForNameInSection(name, spritesstart, spritesend);
+}
+
 //
 // W_GetNumForName
 // Calls W_CheckNumForName, but bombs out if not found.
@@ -412,16 +554,43 @@ lumpindex_t W_GetNumForName(char *name)
     return i;
 }
 
-// Go forwards rather than backwards so we get lump from IWAD and not PWAD
-lumpindex_t W_GetNumForName2(char *name)
+// [BH] Returns the count-th lump with the given name, counting from the first
+static lumpindex_t W_FindNthLump(char *name, unsigned int count)
 {
-    lumpindex_t i;
+    lumpindex_t         i;
+    unsigned int        j = 0;
+
+    if (lumpslots)
+    {
+        lumpindex_t     last = W_CheckNumForName(name);
+
+        for (i = last; i != -1; i = lumpinfo[i]->next)
+            j++;
+
+        if (count < 1 || count > j)
+            return -1;
+
+        // The chain runs from the last lump to the first
+        for (i = last; j > count; j--)
+            i = lumpinfo[i]->next;
+
+        return i;
+    }
 
     for (i = 0; i < numlumps; i++)
         if (!strncasecmp(lumpinfo[i]->name, name, 8))
-            break;
+            if (++j == count)
+                return i;
 
-    if (i == numlumps)
+    return -1;
+}
+
+// Go forwards rather than backwards so we get lump from IWAD and not PWAD
+lumpindex_t W_GetNumForName2(char *name)
+{
+    lumpindex_t i = W_FindNthLump(name, 1);
+
+    if (i < 0)
         I_Error("W_GetNumForName: %s not found!", name);
 
     return i;
@@ -429,15 +598,9 @@ lumpindex_t W_GetNumForName2(char *name)
 
 lumpindex_t W_GetNumForNameX(char *name, unsigned int count)
 {
-    lumpindex_t         i;
-    unsigned int        j = 0;
+    lumpindex_t i = W_FindNthLump(name, count);
 
-    for (i = 0; i < numlumps; i++)
-        if (!strncasecmp(lumpinfo[i]->name, name, 8))
-            if (++j == count)
-                break;
-
-    if (i == numlumps && j != count)
+    if (i < 0)
         I_Error("W_GetNumForNameX: %s not found!", name);
 
     return i;
@@ -479,6 +642,17 @@ void W_ReadLump(lumpindex_t lump, void *dest)
         I_Error("W_ReadLump: only read %i of %i on lump %i", c, l->size, lump);
 }
 
+//
+// [BH] Returns true if lump can be used where it is in its mapped WAD.
+//
+static dboolean W_IsLumpMapped(lumpinfo_t *lump)
+{
+    wad_file_t  *wad_file = lump->wad_file;
+
+    return (wad_file->mapped && lump->size > 0 && lump->position >= 0
+        && (unsigned int)lump->position + lump->size <= wad_file->length);
+}
+
 //
 // W_CacheLumpNum
 //
@@ -490,6 +664,9 @@ void W_ReadLump(lumpindex_t lump, void *dest)
 // PU_STATIC, it should be released back using W_ReleaseLumpNum
 // when no longer needed (do not use Z_ChangeTag).
 //
+// [BH] If the lump's WAD is mapped into memory, a pointer to the lump
+// there is returned instead, and tag is ignored.
+//
 void *W_CacheLumpNum(lumpindex_t lumpnum, int tag)
 {
     byte        *result;
@@ -500,7 +677,18 @@ void *W_CacheLumpNum(lumpindex_t lumpnum, int tag)
 
     lump = lumpinfo[lumpnum];
 
-    if (lump->cache)
+    if (W_IsLumpMapped(lump))
+    {
+        if (!lump->cache)
+        {
+            lump->cache = lump->wad_file->mapped + lump->position;
+            mappedlumps++;
+            mappedlumpsize += lump->size;
+        }
+
+        result = (byte *)lump->cache;
+    }
+    else if (lump->cache)
     {
         // Already cached, so just switch the zone tag.
         result = (byte *)lump->cache;
@@ -512,6 +700,8 @@ void *W_CacheLumpNum(lumpindex_t lumpnum, int tag)
         lump->cache = Z_Malloc(W_LumpLength(lumpnum), tag, &lump->cache);
         W_ReadLump(lumpnum, lump->cache);
         result = (byte *)lump->cache;
+        readlumps++;
+        readlumpsize += lump->size;
     }
 
     return result;
@@ -547,7 +737,9 @@ void W_ReleaseLumpNum(lumpindex_t lumpnum)
 
     lump = lumpinfo[lumpnum];
 
-    Z_ChangeTag(lump->cache, PU_CACHE);
+    // [BH] nothing to release if the lump is still in its mapped WAD
+    if (!W_IsLumpMapped(lump))
+        Z_ChangeTag(lump->cache, PU_CACHE);
 }
 
 void W_ReleaseLumpName(char *name)
@@ -559,30 +751,321 @@ void W_ReleaseLumpName(char *name)
 void W_GenerateHashTable(void)
 {
     // Free the old hash table, if there is one
-    if (lumphash)
-        Z_Free(lumphash);
+    W_FreeHashTable();
 
     // Generate hash table
     if (numlumps > 0)
     {
+        unsigned int    size = 1;
         lumpindex_t     i;
 
-        lumphash = Z_Malloc(sizeof(lumpindex_t) * numlumps, PU_STATIC, NULL);
+        // [BH] keep the table no more than half full
+        while (size < (unsigned int)numlumps * 2)
+            size <<= 1;
 
-        for (i = 0; i < numlumps; i++)
-            lumphash[i] = -1;
+        lumpmask = size - 1;
+        lumpkeys = Z_Malloc(size * sizeof(*lumpkeys), PU_STATIC, NULL);
+        lumpslots = Z_Malloc(size * sizeof(*lumpslots), PU_STATIC, NULL);
+
+        for (i = 0; i < (lumpindex_t)size; i++)
+            lumpslots[i] = -1;
 
         for (i = 0; i < numlumps; i++)
         {
-            unsigned int        hash;
+            uint64_t            key = W_LumpNameKey(lumpinfo[i]->name);
+            unsigned int        slot = W_LumpKeySlot(key);
 
-            hash = W_LumpNameHash(lumpinfo[i]->name) % numlumps;
+            while (lumpslots[slot] != -1 && lumpkeys[slot] != key)
+                slot = (slot + 1) & lumpmask;
+
+            // Hook into the hash table, so that later lumps take precedence
+            lumpinfo[i]->next = lumpslots[slot];
+            lumpkeys[slot] = key;
+            lumpslots[slot] = i;
+        }
+
+        if ((i = W_CheckNumForName("F_START")) >= 0)
+        {
+            flatsstart = i + 1;
+            flatsend = W_CheckNumForName("F_END") - 1;
+        }
 
-            // Hook into the hash table
-            lumpinfo[i]->next = lumphash[hash];
-            lumphash[hash] = i;
+        if ((i = W_CheckNumForName("S_START")) >= 0)
+        {
+            spritesstart = i + 1;
+            spritesend = W_CheckNumForName("S_END") - 1;
         }
     }
 
     // All done!
 }
+
+//
+// W_HashData
+// [BH] 64-bit FNV-1a hash, continued from the given hash. The data is taken eight bytes
+//  at a time, with any that are left over taken one at a time.
+//
+uint64_t W_HashData(uint64_t hash, const void *data, size_t size)
+{
+    const byte  *p = data;
+
+    if (!hash)
+        hash = 0xCBF29CE484222325ull;
+
+    for (; size >= sizeof(uint64_t); size -= sizeof(uint64_t), p += sizeof(uint64_t))
+    {
+        uint64_t    word;
+
+        memcpy(&word, p, sizeof(word));
+        hash = (hash ^ word) * 0x100000001B3ull;
+    }
+
+    while (size--)
+        hash = (hash ^ *p++) * 0x100000001B3ull;
+
+    return hash;
+}
+
+// [BH] Hash the whole contents of a WAD
+static uint64_t W_HashFile(uint64_t hash, wad_file_t *wad_file)
+{
+    byte            *buffer;
+    unsigned int    offset;
+
+    if (wad_file->mapped)
+        return W_HashData(hash, wad_file->mapped, wad_file->length);
+
+    buffer = malloc(65536);
+
+    for (offset = 0; offset < wad_file->length; offset += 65536)
+    {
+        size_t  length = MIN(wad_file->length - offset, 65536);
+
+        if (W_Read(wad_file, offset, buffer, length) != length)
+            break;
+
+        hash = W_HashData(hash, buffer, length);
+    }
+
+    free(buffer);
+    return hash;
+}
+
+//
+// W_FindWADHash
+// [BH] Look for the hash of the contents of a WAD with the given path, length and
+//  modification time in the "wads" file from the startup cache.
+//
+static dboolean W_FindWADHash(const byte *wads, size_t size, const char *path, int64_t length,
+    int64_t mtime, uint64_t *hash)
+{
+    size_t  pathlength = strlen(path);
+    size_t  offset = 0;
+
+    while (offset + sizeof(cachewad_t) <= size)
+    {
+        cachewad_t  wad;
+
+        memcpy(&wad, wads + offset, sizeof(wad));
+        offset += sizeof(wad);
+
+        if (wad.pathlength < 0 || offset + wad.pathlength > size)
+            break;
+
+        if (wad.length == length && wad.mtime == mtime && (size_t)wad.pathlength == pathlength
+            && !memcmp(wads + offset, path, pathlength))
+        {
+            *hash = wad.hash;
+            return true;
+        }
+
+        offset += wad.pathlength;
+    }
+
+    return false;
+}
+
+//
+// W_HashWADs
+// [BH] Hash the size, modification time and contents of every WAD that's been loaded, and
+//  their lump directory once they've been merged. This is only done once. The contents of
+//  a WAD are only hashed again if its size or modification time has changed since the
+//  last time, as every byte would otherwise need to be read in on every startup.
+//
+uint64_t W_HashWADs(void)
+{
+    static uint64_t hash;
+    wad_file_t      *wad_file = NULL;
+    byte            *wads;
+    byte            *newwads = NULL;
+    size_t          size = 0;
+    size_t          newsize = 0;
+    uint64_t        start = I_GetTimeUS();
+    int             i;
+
+    if (hash)
+        return hash;
+
+    // the startup cache isn't used, so neither is the hash
+    if (nocache)
+        return (hash = 1);
+
+    wads = W_LoadCache("wads", 0, &size);
+    hash = W_HashData(0, &numlumps, sizeof(numlumps));
+
+    for (i = 0; i < numlumps; i++)
+    {
+        lumpinfo_t  *lump = lumpinfo[i];
+
+        if (lump->wad_file != wad_file)
+        {
+            struct stat status;
+            cachewad_t  wad;
+            uint64_t    wadhash;
+
+            wad_file = lump->wad_file;
+            wad.length = wad_file->length;
+            wad.mtime = (!stat(wad_file->path, &status) ? (int64_t)status.st_mtime : 0);
+            wad.pathlength = (int)strlen(wad_file->path);
+
+            if (!wads || !W_FindWADHash(wads, size, wad_file->path, wad.length, wad.mtime, &wadhash))
+            {
+                wadhash = W_HashFile(0, wad_file);
+                hashedwads++;
+            }
+
+            wad.hash = wadhash;
+
+            newwads = Z_Realloc(newwads, newsize + sizeof(wad) + wad.pathlength);
+            memcpy(newwads + newsize, &wad, sizeof(wad));
+            memcpy(newwads + newsize + sizeof(wad), wad_file->path, wad.pathlength);
+            newsize += sizeof(wad) + wad.pathlength;
+
+            hash = W_HashData(hash, wad_file->path, wad.pathlength);
+            hash = W_HashData(hash, &wad.length, sizeof(wad.length));
+            hash = W_HashData(hash, &wad.mtime, sizeof(wad.mtime));
+            hash = W_HashData(hash, &wadhash, sizeof(wadhash));
+        }
+
+        hash = W_HashData(hash, lump->name, sizeof(lump->name));
+        hash = W_HashData(hash, &lump->position, sizeof(lump->position));
+        hash = W_HashData(hash, &lump->size, sizeof(lump->size));
+    }
+
+    if (hashedwads || newsize != size)
+        W_SaveCache("wads", 0, newwads, newsize);
+
+    if (wads)
+        Z_Free(wads);
+
+    free(newwads);
+    hashedwadstime = (int)((I_GetTimeUS() - start) / 1000);
+
+    return hash;
+}
+
+// [BH] Replace the file at path with the one at temppath in one step
+static dboolean W_ReplaceFile(const char *temppath, const char *path)
+{
+#if defined(_WIN32)
+    return MoveFileExA(temppath, path, (MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH));
+#else
+    return !rename(temppath, path);
+#endif
+}
+
+static char *W_CachePath(const char *name)
+{
+    if (!cachefolder)
+        cachefolder = M_StringJoin(M_GetAppDataFolder(), DIR_SEPARATOR_S, "cache", NULL);
+
+    return M_StringJoin(cachefolder, DIR_SEPARATOR_S, name, ".cache", NULL);
+}
+
+//
+// W_LoadCache
+// [BH] Returns a copy in the zone of the data saved in the startup cache by W_SaveCache()
+//  under the same name and key, and how many bytes there are in size, or NULL if there
+//  aren't any.
+//
+void *W_LoadCache(const char *name, uint64_t key, size_t *size)
+{
+    char            *path;
+    wad_file_t      *file;
+    cacheheader_t   header;
+    byte            *data = NULL;
+
+    if (nocache)
+        return NULL;
+
+    path = W_CachePath(name);
+    file = W_OpenFile(path);
+    free(path);
+
+    if (!file)
+        return NULL;
+
+    if (file->length >= sizeof(header) && W_Read(file, 0, &header, sizeof(header)) == sizeof(header)
+        && !memcmp(header.identification, CACHEID, sizeof(header.identification))
+        && header.version == CACHEVERSION && header.size >= 0
+        && file->length - sizeof(header) == (size_t)header.size && header.key == key)
+    {
+        *size = header.size;
+        data = Z_Malloc(MAX(1, header.size), PU_STATIC, NULL);
+
+        if (file->mapped)
+            memcpy(data, file->mapped + sizeof(header), *size);
+        else if (W_Read(file, sizeof(header), data, *size) != *size)
+        {
+            Z_Free(data);
+            data = NULL;
+        }
+    }
+
+    W_CloseFile(file);
+    return data;
+}
+
+//
+// W_SaveCache
+// [BH] Save size bytes of data in the startup cache under the given name and key. The
+//  file is written under another name first, and then replaces the old one in one step,
+//  so a cache that's only partly written is never used.
+//
+void W_SaveCache(const char *name, uint64_t key, const void *data, size_t size)
+{
+    char            *path;
+    char            *temppath;
+    FILE            *file;
+    cacheheader_t   header;
+    dboolean        success;
+
+    if (nocache)
+        return;
+
+    path = W_CachePath(name);
+    temppath = M_StringJoin(path, ".tmp", NULL);
+    M_MakeDirectory(cachefolder);
+
+    if (!(file = fopen(temppath, "wb")))
+    {
+        free(path);
+        free(temppath);
+        return;
+    }
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.identification, CACHEID, sizeof(header.identification));
+    header.version = CACHEVERSION;
+    header.size = (int)size;
+    header.key = key;
+
+    success = (fwrite(&header, sizeof(header), 1, file) == 1 && fwrite(data, 1, size, file) == size);
+    success &= !fclose(file);
+
+    if (!success || !W_ReplaceFile(temppath, path))
+        remove(temppath);
+
+    free(path);
+    free(temppath);
+}
@@ -72,11 +72,22 @@ struct lumpinfo_s
 extern lumpinfo_t       **lumpinfo;
 extern int              numlumps;
 
+extern int              mappedlumps;
+extern int              readlumps;
+extern uint64_t         mappedlumpsize;
+extern uint64_t         readlumpsize;
+
+extern dboolean         nocache;
+extern int              hashedwads;
+extern int              hashedwadstime;
+
 wad_file_t *W_AddFile(char *filename, dboolean automatic);
 int W_WadType(char *filename);
 
 lumpindex_t W_CheckNumForName(char *name);
 lumpindex_t W_RangeCheckNumForName(lumpindex_t min, lumpindex_t max, char *name);
+lumpindex_t W_CheckNumForFlat(char *name);
+lumpindex_t W_CheckNumForSprite(char *name);
 lumpindex_t W_GetNumForName(char *name);
 lumpindex_t W_GetNumForName2(char *name);
 lumpindex_t W_GetNumForNameX(char *name, unsigned int count);
@@ -97,6 +108,11 @@ unsigned int W_LumpNameHash(const char *s);
 void W_ReleaseLumpNum(lumpindex_t lump);
 void W_ReleaseLumpName(char *name);
 
+uint64_t W_HashData(uint64_t hash, const void *data, size_t size);
+uint64_t W_HashWADs(void);
+void *W_LoadCache(const char *name, uint64_t key, size_t *size);
+void W_SaveCache(const char *name, uint64_t key, const void *data, size_t size);
+
 int IWADRequiredByPWAD(const char *pwadname);
 dboolean HasDehackedLump(const char *pwadname);
 
@@ -42,12 +42,16 @@
 // Minimum chunk size at which blocks are allocated
 #define CHUNK_SIZE      32
 
+// Number of objects in each slab of a pool
+#define POOL_SLABSIZE   256
+
 typedef struct memblock
 {
     struct memblock     *next;
     struct memblock     *prev;
     size_t              size;
     void                **user;
+    zpool_t             *pool;
     unsigned char       tag;
 } memblock_t;
 
@@ -58,6 +62,42 @@ static const size_t     HEADER_SIZE = (sizeof(memblock_t) + CHUNK_SIZE - 1) & ~(
 
 static memblock_t       *blockbytag[PU_MAX];
 
+zpool_t                 *zpools;
+
+//
+// Z_LinkBlock
+//
+static void Z_LinkBlock(memblock_t *block, int32_t tag)
+{
+    if (!blockbytag[tag])
+    {
+        blockbytag[tag] = block;
+        block->next = block->prev = block;
+    }
+    else
+    {
+        blockbytag[tag]->prev->next = block;
+        block->prev = blockbytag[tag]->prev;
+        block->next = blockbytag[tag];
+        blockbytag[tag]->prev = block;
+    }
+
+    block->tag = tag;
+}
+
+//
+// Z_UnlinkBlock
+//
+static void Z_UnlinkBlock(memblock_t *block)
+{
+    if (block == block->next)
+        blockbytag[block->tag] = NULL;
+    else if (blockbytag[block->tag] == block)
+        blockbytag[block->tag] = block->next;
+    block->prev->next = block->next;
+    block->next->prev = block->prev;
+}
+
 //
 // Z_Malloc
 // You can pass a NULL user if the tag is < PU_PURGELEVEL.
@@ -86,23 +126,11 @@ void *Z_Malloc(size_t size, int32_t tag, void **user)
         Z_FreeTags(PU_CACHE, PU_CACHE);
     }
 
-    if (!blockbytag[tag])
-    {
-        blockbytag[tag] = block;
-        block->next = block->prev = block;
-    }
-    else
-    {
-        blockbytag[tag]->prev->next = block;
-        block->prev = blockbytag[tag]->prev;
-        block->next = blockbytag[tag];
-        blockbytag[tag]->prev = block;
-    }
+    Z_LinkBlock(block, tag);                            // tag
 
     block->size = size;
-
-    block->tag = tag;                                   // tag
     block->user = user;                                 // user
+    block->pool = NULL;
     block = (memblock_t *)((char *)block + HEADER_SIZE);
     if (user)                                           // if there is a user
         *user = block;                                  // set user to point to new block
@@ -134,14 +162,20 @@ void Z_Free(void *ptr)
     if (block->user)                                    // Nullify user if one exists
         *block->user = NULL;
 
-    if (block == block->next)
-        blockbytag[block->tag] = NULL;
-    else if (blockbytag[block->tag] == block)
-        blockbytag[block->tag] = block->next;
-    block->prev->next = block->next;
-    block->next->prev = block->prev;
+    Z_UnlinkBlock(block);
+
+    if (block->pool)
+    {
+        // [BH] return the object to its pool
+        zpool_t *pool = block->pool;
 
-    free(block);
+        block->next = pool->freelist;
+        pool->freelist = block;
+        pool->live--;
+        pool->pooled++;
+    }
+    else
+        free(block);
 }
 
 void Z_FreeTags(int32_t lowtag, int32_t hightag)
@@ -170,6 +204,30 @@ void Z_FreeTags(int32_t lowtag, int32_t hightag)
             block = next;                               // Advance to next block
         }
     }
+
+    // [BH] release the slabs of any pools that are no longer used
+    {
+        zpool_t *pool;
+
+        for (pool = zpools; pool; pool = pool->next)
+            if (!pool->live && pool->slabs)
+            {
+                void    *slab = pool->slabs;
+
+                while (slab)
+                {
+                    void    *next = *(void **)slab;
+
+                    free(slab);
+                    slab = next;
+                }
+
+                pool->slabs = NULL;
+                pool->freelist = NULL;
+                pool->numslabs = 0;
+                pool->pooled = 0;
+            }
+    }
 }
 
 void Z_ChangeTag(void *ptr, int32_t tag)
@@ -185,25 +243,71 @@ void Z_ChangeTag(void *ptr, int32_t tag)
     if (tag == block->tag)
         return;
 
-    if (block == block->next)
-        blockbytag[block->tag] = NULL;
-    else if (blockbytag[block->tag] == block)
-        blockbytag[block->tag] = block->next;
-    block->prev->next = block->next;
-    block->next->prev = block->prev;
+    Z_UnlinkBlock(block);
+    Z_LinkBlock(block, tag);
+}
 
-    if (!blockbytag[tag])
-    {
-        blockbytag[tag] = block;
-        block->next = block->prev = block;
-    }
-    else
+//
+// Z_PoolMalloc
+// [BH] Allocate an object from a pool, adding another slab to it if it's full.
+//
+void *Z_PoolMalloc(zpool_t *pool, int32_t tag, void **user)
+{
+    memblock_t  *block;
+
+    if (!pool->freelist)
     {
-        blockbytag[tag]->prev->next = block;
-        block->prev = blockbytag[tag]->prev;
-        block->next = blockbytag[tag];
-        blockbytag[tag]->prev = block;
+        size_t  stride = HEADER_SIZE + ((pool->size + CHUNK_SIZE - 1) & ~(CHUNK_SIZE - 1));
+        char    *slab;
+        int     i;
+
+        while (!(slab = malloc(HEADER_SIZE + POOL_SLABSIZE * stride)))
+        {
+            if (!blockbytag[PU_CACHE])
+                I_Error("Z_PoolMalloc: Failure trying to allocate %lu bytes",
+                    (unsigned long)(POOL_SLABSIZE * stride));
+            Z_FreeTags(PU_CACHE, PU_CACHE);
+        }
+
+        if (!pool->numslabs++ && !pool->peak)
+        {
+            pool->next = zpools;
+            zpools = pool;
+        }
+
+        *(void **)slab = pool->slabs;
+        pool->slabs = slab;
+
+        // thread the new objects onto the free list in order
+        for (i = POOL_SLABSIZE - 1; i >= 0; i--)
+        {
+            block = (memblock_t *)(slab + HEADER_SIZE + i * stride);
+            block->pool = pool;
+            block->size = stride - HEADER_SIZE;
+            block->next = pool->freelist;
+            pool->freelist = block;
+        }
+
+        pool->pooled += POOL_SLABSIZE;
     }
 
-    block->tag = tag;
+    block = pool->freelist;
+    pool->freelist = block->next;
+    pool->pooled--;
+
+    if (++pool->live > pool->peak)
+        pool->peak = pool->live;
+
+    Z_LinkBlock(block, tag);
+    block->user = user;
+    block = (memblock_t *)((char *)block + HEADER_SIZE);
+    if (user)
+        *user = block;
+
+    return block;
+}
+
+void *Z_PoolCalloc(zpool_t *pool, int32_t tag, void **user)
+{
+    return memset(Z_PoolMalloc(pool, tag, user), 0, pool->size);
 }
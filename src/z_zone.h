@@ -64,11 +64,33 @@ enum
 
 #define PU_PURGELEVEL    PU_CACHE    // First purgeable tag's level
 
+// [BH] A pool of objects of the same size, allocated in slabs and reused through a
+//  free list rather than going through malloc() and free() each time. Objects from a
+//  pool are freed and change tag in the same way as any other block.
+typedef struct zpool_s
+{
+    const char          *name;
+    size_t              size;
+    void                *slabs;
+    void                *freelist;
+    int                 numslabs;
+    int                 live;
+    int                 peak;
+    int                 pooled;
+    struct zpool_s      *next;
+} zpool_t;
+
+#define ZPOOL(name, type)   { name, sizeof(type), NULL, NULL, 0, 0, 0, 0, NULL }
+
+extern zpool_t          *zpools;
+
 void *Z_Malloc(size_t size, int32_t tag, void **user);
 void *Z_Calloc(size_t n1, size_t n2, int32_t tag, void **user);
 void *Z_Realloc(void *ptr, size_t size);
 void Z_Free(void *ptr);
 void Z_FreeTags(int32_t lowtag, int32_t hightag);
 void Z_ChangeTag(void *ptr, int32_t tag);
+void *Z_PoolMalloc(zpool_t *pool, int32_t tag, void **user);
+void *Z_PoolCalloc(zpool_t *pool, int32_t tag, void **user);
 
 #endif